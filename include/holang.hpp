@@ -12,4 +12,8 @@
 namespace holang {
 int size_local_idents();
 void set_func(const std::string &name, Func *func);
+// Call a function or block from native code and return its result.
+Value call_func_argc_zero(Value *self, Func *func);
+Value call_func_argc_one(Value *self, Func *func, Value *arg);
+Value call_func_argc_two(Value *self, Func *func, Value *args);
 } // namespace holang
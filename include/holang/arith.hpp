@@ -0,0 +1,11 @@
+#pragma once
+
+#include "holang/instruction.hpp"
+#include "holang/value.hpp"
+
+namespace holang {
+// Evaluates a binary operator instruction (ADD ... EQUAL) for any pair of
+// operands. The VM handles int/int without overflow and double/double
+// inline and calls this for mixed operands, overflowing ints and bignums.
+Value binop_generic(Instruction op, const Value &lhs, const Value &rhs);
+} // namespace holang
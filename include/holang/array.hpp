@@ -0,0 +1,42 @@
+#pragma once
+
+#include "holang/object.hpp"
+#include "holang/value.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace holang {
+/*
+ * Array of Values stored contiguously.
+ *
+ * Indexing with an int in range is done by the VM itself (IDX_LOAD and
+ * IDX_STORE); everything else, such as negative indices, goes through the
+ * "[]" and "[]=" methods.
+ */
+class Array : public Object {
+public:
+  Array() { klass = Klass::Array; }
+  Array(std::vector<Value> &&elements) : elements(std::move(elements)) {
+    klass = Klass::Array;
+  }
+
+  static bool is_array(const Value &v) {
+    return v.type == Type::OBJECT && v.objval->klass == Klass::Array;
+  }
+
+  // pointer to the element at `index`, or nullptr when it is out of range
+  Value *at(int64_t index) {
+    if (static_cast<uint64_t>(index) < elements.size()) {
+      return &elements[index];
+    }
+    return nullptr;
+  }
+
+  virtual const std::string to_s();
+  virtual void write_to(OutputBuffer &out);
+
+  static void init();
+
+  std::vector<Value> elements;
+};
+} // namespace holang
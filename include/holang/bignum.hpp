@@ -0,0 +1,56 @@
+#pragma once
+
+#include "holang/object.hpp"
+#include "holang/value.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace holang {
+/*
+ * Arbitrary-precision integer.
+ *
+ * Integers are 64-bit Values. The VM promotes a result to a BigInt only
+ * when 64-bit arithmetic overflows, and every operation here demotes its
+ * result back to an int Value when it fits. The operands of the static
+ * functions may be int Values or BigInts.
+ */
+class BigInt : public Object {
+public:
+  // little-endian base 2^32 digits without leading zeros
+  using Digits = std::vector<uint32_t>;
+
+  BigInt(bool negative, Digits &&digits);
+
+  static bool is_bigint(const Value &v) {
+    return v.type == Type::OBJECT && v.objval->klass == Klass::BigInt;
+  }
+  static bool is_integer(const Value &v) {
+    return v.type == Type::INT || is_bigint(v);
+  }
+
+  static Value add(const Value &lhs, const Value &rhs);
+  static Value sub(const Value &lhs, const Value &rhs);
+  static Value mul(const Value &lhs, const Value &rhs);
+  // truncated toward zero like the int operators
+  static Value div(const Value &lhs, const Value &rhs);
+  static Value mod(const Value &lhs, const Value &rhs);
+  static int compare(const Value &lhs, const Value &rhs);
+  static double to_double(const Value &v);
+
+  bool is_negative() const { return negative; }
+  const Digits &get_digits() const { return digits; }
+
+  virtual const std::string to_s();
+
+  // int Value when it fits, BigInt otherwise
+  static Value normalize(bool negative, Digits &&digits);
+
+  static void init();
+
+private:
+
+  bool negative;
+  Digits digits;
+};
+} // namespace holang
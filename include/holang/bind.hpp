@@ -0,0 +1,268 @@
+#pragma once
+
+#include "holang/array.hpp"
+#include "holang/object.hpp"
+#include "holang/string.hpp"
+#include "holang/value.hpp"
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace holang {
+// How a C++ type of a bound function is taken from and made into a Value.
+template <typename T> struct Convert;
+
+template <> struct Convert<Value> {
+  static constexpr const char *name = "Value";
+  static bool is(const Value &) { return true; }
+  static Value from(const Value &v) { return v; }
+  static Value to(const Value &v) { return v; }
+};
+
+template <> struct Convert<int64_t> {
+  static constexpr const char *name = "Int";
+  static bool is(const Value &v) { return v.type == Type::INT; }
+  static int64_t from(const Value &v) { return v.ival; }
+  static Value to(int64_t i) { return Value(i); }
+};
+
+template <> struct Convert<int> {
+  static constexpr const char *name = "Int";
+  static bool is(const Value &v) { return v.type == Type::INT; }
+  static int from(const Value &v) { return static_cast<int>(v.ival); }
+  static Value to(int i) { return Value(i); }
+};
+
+// an Int argument is widened
+template <> struct Convert<double> {
+  static constexpr const char *name = "Double";
+  static bool is(const Value &v) {
+    return v.type == Type::DOUBLE || v.type == Type::INT;
+  }
+  static double from(const Value &v) {
+    return v.type == Type::INT ? static_cast<double>(v.ival) : v.dval;
+  }
+  static Value to(double d) { return Value(d); }
+};
+
+template <> struct Convert<bool> {
+  static constexpr const char *name = "Bool";
+  static bool is(const Value &v) { return v.type == Type::BOOL; }
+  static bool from(const Value &v) { return v.bval; }
+  static Value to(bool b) { return Value(b); }
+};
+
+// an object of a builtin class, told apart by `is_t`
+template <typename T, bool (*is_t)(const Value &)> struct ConvertObject {
+  static bool is(const Value &v) { return is_t(v); }
+  static T *from(const Value &v) { return (T *)v.objval; }
+  static Value to(T *obj) { return Value((Object *)obj); }
+};
+
+template <>
+struct Convert<String *> : ConvertObject<String, &String::is_string> {
+  static constexpr const char *name = "String";
+};
+
+template <> struct Convert<std::string> {
+  static constexpr const char *name = "String";
+  static bool is(const Value &v) { return String::is_string(v); }
+  static std::string from(const Value &v) {
+    return ((String *)v.objval)->str();
+  }
+  static Value to(const std::string &str) {
+    return Value((Object *)new String(str));
+  }
+};
+
+template <> struct Convert<Array *> : ConvertObject<Array, &Array::is_array> {
+  static constexpr const char *name = "Array";
+};
+
+// a block
+template <> struct Convert<Func *> {
+  static constexpr const char *name = "block";
+  static bool is(const Value &v) { return v.type == Type::FUNCTION; }
+  static Func *from(const Value &v) { return v.funcval; }
+  static Value to(Func *func) { return Value(func); }
+};
+
+// The arguments from a parameter of this type on, for a function taking any
+// number of them. Parameters after it take the last arguments:
+//
+//   static Future *spawn(Args args, Func *block);
+struct Args {
+  Value *values;
+  int count;
+
+  Value *begin() const { return values; }
+  Value *end() const { return values + count; }
+  int size() const { return count; }
+  Value &operator[](int i) const { return values[i]; }
+};
+
+// A parameter of type std::optional<T> after the others takes an argument
+// which may be left out.
+template <typename T> struct IsOptional : std::false_type {};
+template <typename T> struct IsOptional<std::optional<T>> : std::true_type {};
+
+// What the parameters of a bound function are, from `first` on.
+template <typename... A> struct Params {
+  static constexpr bool rest_at[] = {
+      std::is_same<std::decay_t<A>, Args>::value..., false};
+  static constexpr bool optional_at[] = {
+      IsOptional<std::decay_t<A>>::value..., false};
+
+  // index of the Args parameter, or -1
+  static constexpr int find_rest(int first) {
+    int rest = -1;
+    for (int i = first; i < (int)sizeof...(A); i++) {
+      rest = rest_at[i] ? i - first : rest;
+    }
+    return rest;
+  }
+
+  static constexpr int count_optionals(int first) {
+    int count = 0;
+    for (int i = first; i < (int)sizeof...(A); i++) {
+      count += optional_at[i] ? 1 : 0;
+    }
+    return count;
+  }
+
+  // at most one Args, no optional parameters next to it or before a
+  // required one, and neither for the receiver
+  static constexpr bool valid(int first) {
+    int rests = 0;
+    bool optional = false;
+    for (int i = 0; i < (int)sizeof...(A); i++) {
+      if ((rest_at[i] || optional_at[i]) && i < first) {
+        return false;
+      }
+      if ((optional && !optional_at[i]) || (rest_at[i] && ++rests > 1)) {
+        return false;
+      }
+      optional = optional || optional_at[i];
+    }
+    return !(optional && rests != 0);
+  }
+};
+
+template <typename F, F fn, bool method> struct Binding;
+
+template <typename R, typename... A, R (*fn)(A...), bool method>
+struct Binding<R (*)(A...), fn, method> {
+  // parameter index of the first script argument; a method's first
+  // parameter takes the receiver
+  static constexpr int first = method ? 1 : 0;
+  static constexpr int params = sizeof...(A) - first;
+  static_assert(Params<A...>::valid(first),
+                "one Args parameter, or std::optional parameters after the "
+                "others, and not for the receiver");
+
+  // index of the Args parameter among the script arguments, or -1
+  static constexpr int rest = Params<A...>::find_rest(first);
+  // the number of script arguments, without the ones of Args, and how many
+  // of them may be left out
+  static constexpr int arity = params - (rest >= 0 ? 1 : 0);
+  static constexpr int optionals = Params<A...>::count_optionals(first);
+  static constexpr bool takes_block =
+      (std::is_same<std::decay_t<A>, Func *>::value || ...);
+
+  static Value call(Value *self, Value *args, int argc) {
+    // like a script method, one which takes no block ignores a block
+    if (!takes_block && rest < 0 && argc == arity + 1 &&
+        args[arity].type == Type::FUNCTION) {
+      argc--;
+    }
+    if (argc < arity - optionals || (rest < 0 && argc > arity)) {
+      std::cerr << "wrong number of arguments (given " << argc
+                << ", expected " << arity - optionals;
+      if (rest >= 0) {
+        std::cerr << "+";
+      } else if (optionals != 0) {
+        std::cerr << ".." << arity;
+      }
+      std::cerr << ")" << std::endl;
+      exit(1);
+    }
+    return apply(self, args, argc, std::index_sequence_for<A...>());
+  }
+
+private:
+  // the argument at `index` as a T; -1 is the receiver
+  template <typename T>
+  static T convert(Value *self, Value *args, int index) {
+    const Value &v = index < 0 ? *self : args[index];
+    if (!Convert<T>::is(v)) {
+      if (index < 0) {
+        std::cerr << "receiver must be " << Convert<T>::name << std::endl;
+      } else {
+        std::cerr << "argument " << index + 1 << " must be "
+                  << Convert<T>::name << std::endl;
+      }
+      exit(1);
+    }
+    return Convert<T>::from(v);
+  }
+
+  // parameter I of `fn`
+  template <size_t I, typename T>
+  static T take(Value *self, Value *args, int argc) {
+    constexpr int i = static_cast<int>(I) - first;
+    if constexpr (i < 0) {
+      return convert<T>(self, args, -1);
+    } else if constexpr (std::is_same<T, Args>::value) {
+      return Args{args + i, argc - arity};
+    } else if constexpr (IsOptional<T>::value) {
+      if (i >= argc) {
+        return std::nullopt;
+      }
+      return convert<typename T::value_type>(self, args, i);
+    } else if constexpr (rest >= 0 && i > rest) {
+      return convert<T>(self, args, argc - (params - i));
+    } else {
+      return convert<T>(self, args, i);
+    }
+  }
+
+  template <size_t... I>
+  static Value apply(Value *self, Value *args, int argc,
+                     std::index_sequence<I...>) {
+    // a braced list converts the arguments in order
+    std::tuple<std::decay_t<A>...> values{
+        take<I, std::decay_t<A>>(self, args, argc)...};
+    if constexpr (std::is_void<R>::value) {
+      std::apply(fn, std::move(values));
+      return method ? *self : Value(true);
+    } else {
+      return Convert<std::decay_t<R>>::to(std::apply(fn, std::move(values)));
+    }
+  }
+};
+
+/*
+ * bind<&fn>() is a NativeFunc calling the C++ function `fn`: a trampoline
+ * made at compile time which checks the number of arguments and their
+ * types, converts them to the parameters of `fn` and its result back to a
+ * Value. bind_method<&fn>() also passes the receiver as the first
+ * parameter. A void function returns the receiver of a method, or true.
+ * An Args parameter takes any number of arguments and std::optional ones
+ * may be left out.
+ *
+ *   static int64_t count(String *str, String *sub);
+ *   Klass::String->set_method("count", new Func(bind_method<&count>()));
+ */
+template <auto fn> constexpr NativeFunc bind() {
+  return &Binding<decltype(fn), fn, false>::call;
+}
+
+template <auto fn> constexpr NativeFunc bind_method() {
+  return &Binding<decltype(fn), fn, true>::call;
+}
+} // namespace holang
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "holang/bind.hpp"
+#include "holang/channel.hpp"
+#include "holang/coroutine.hpp"
+#include "holang/event_loop.hpp"
+#include "holang/file.hpp"
+#include "holang/hash.hpp"
+#include "holang/lazy.hpp"
+#include "holang/range.hpp"
+#include "holang/scheduler.hpp"
+#include "holang/string.hpp"
+
+// Convert for the other builtin classes, which the natives of the library
+// take and return; embedders need only holang/bind.hpp.
+namespace holang {
+template <> struct Convert<Hash *> : ConvertObject<Hash, &Hash::is_hash> {
+  static constexpr const char *name = "Hash";
+};
+
+template <> struct Convert<Range *> : ConvertObject<Range, &Range::is_range> {
+  static constexpr const char *name = "Range";
+};
+
+template <>
+struct Convert<Channel *> : ConvertObject<Channel, &Channel::is_channel> {
+  static constexpr const char *name = "Channel";
+};
+
+template <>
+struct Convert<Coroutine *>
+    : ConvertObject<Coroutine, &Coroutine::is_coroutine> {
+  static constexpr const char *name = "Coroutine";
+};
+
+template <>
+struct Convert<Future *> : ConvertObject<Future, &Future::is_future> {
+  static constexpr const char *name = "Future";
+};
+
+template <>
+struct Convert<Stream *> : ConvertObject<Stream, &Stream::is_stream> {
+  static constexpr const char *name = "Stream";
+};
+
+template <>
+struct Convert<FileWriter *>
+    : ConvertObject<FileWriter, &FileWriter::is_file_writer> {
+  static constexpr const char *name = "FileWriter";
+};
+
+template <>
+struct Convert<StringBuilder *>
+    : ConvertObject<StringBuilder, &StringBuilder::is_string_builder> {
+  static constexpr const char *name = "StringBuilder";
+};
+
+template <> struct Convert<Lazy *> : ConvertObject<Lazy, &Lazy::is_lazy> {
+  static constexpr const char *name = "Lazy";
+};
+} // namespace holang
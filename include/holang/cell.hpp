@@ -0,0 +1,25 @@
+#pragma once
+
+#include "holang/object.hpp"
+#include "holang/value.hpp"
+
+namespace holang {
+// A local variable which blocks use. Its slot holds the cell, which the
+// closures of the blocks share, so that an assignment in either frame is
+// seen by the other (see MAKE_CELL and MAKE_CLOSURE). Scripts never get a
+// cell as a value.
+class Cell : public Object {
+public:
+  Cell(const Value &value) : value(value) { klass = &tag; }
+
+  static bool is_cell(const Value &v) {
+    return v.type == Type::OBJECT && v.objval->klass == &tag;
+  }
+
+  Value value;
+
+private:
+  // the class of every cell, only compared with
+  static Klass tag;
+};
+} // namespace holang
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "holang/object.hpp"
+#include "holang/value.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace holang {
+class ChannelQueue;
+
+/*
+ * A Value detached from any isolate, as it travels through a channel.
+ *
+ * Objects belong to the isolate which made them (their classes are that
+ * isolate's), so send() packs a value into a tree of Messages and recv()
+ * unpacks it into new objects of the receiving isolate. Ints, doubles and
+ * bools are copied; a String moves no bytes when it has a heap buffer, as
+ * strings are immutable and the buffer is refcounted; arrays, hashes,
+ * ranges and big ints are copied deeply; a Channel is sent as a handle of
+ * the same queue. Cyclic arrays and other objects can not be sent.
+ */
+struct Message {
+  enum class Kind { INT, DOUBLE, BOOL, STRING, BIGINT, RANGE, ARRAY, HASH,
+                    CHANNEL };
+
+  Kind kind = Kind::BOOL;
+  int64_t ival = 0; // INT, the first of a RANGE
+  int64_t last = 0; // RANGE
+  double dval = 0;
+  bool bval = false; // BOOL, the sign of a BIGINT
+  // STRING: [chars, chars + size) of `buffer`, or `bytes` for a short one
+  std::shared_ptr<const char> buffer;
+  const char *chars = nullptr;
+  size_t size = 0;
+  std::string bytes;
+  std::vector<uint32_t> digits;  // BIGINT
+  std::vector<Message> elements; // ARRAY; keys and values of a HASH
+  std::shared_ptr<ChannelQueue> channel;
+
+  // exits with an error naming `who` for a value which can not be sent
+  static Message pack(const Value &value, const char *who);
+  // new objects of the current isolate
+  Value unpack() const;
+};
+
+/*
+ * Bounded multi-producer multi-consumer queue of Messages (Vyukov's
+ * bounded MPMC queue).
+ *
+ * Each slot carries a sequence number telling whether it is free for the
+ * producer of a given position or full for the consumer of it, so
+ * try_push() and try_pop() only take a position with one CAS and never
+ * lock. The slots are rounded up to a power of two, but at most `capacity`
+ * positions are taken and not yet popped. close() sets CLOSED_BIT in
+ * enqueue_pos, which fails the CAS of any later push: a push either takes
+ * its position before the close, and is popped, or reports CLOSED.
+ * Blocking operations spin briefly and then sleep on a Waiter; a push, pop
+ * or close wakes the registered waiters, which retry. Shared by every
+ * Channel object, in any isolate, that refers to it.
+ */
+class ChannelQueue {
+public:
+  enum class Status { OK, EMPTY, FULL, CLOSED };
+
+  explicit ChannelQueue(size_t capacity);
+  ChannelQueue(const ChannelQueue &) = delete;
+  ChannelQueue &operator=(const ChannelQueue &) = delete;
+
+  // OK, FULL or CLOSED
+  Status try_push(Message &&message);
+  // OK, EMPTY, or CLOSED once closed and drained
+  Status try_pop(Message &message);
+  // OK or CLOSED
+  Status push(Message &&message);
+  Status pop(Message &message);
+  void close();
+  bool is_closed() const {
+    return (enqueue_pos.load(std::memory_order_acquire) & CLOSED_BIT) != 0;
+  }
+  size_t get_capacity() const { return capacity; }
+
+  // a thread sleeping until one of the queues it is registered with
+  // changes
+  struct Waiter {
+    std::mutex mutex;
+    std::condition_variable changed;
+    bool signaled = false;
+
+    void wait();
+  };
+  void add_waiter(Waiter *waiter);
+  void remove_waiter(Waiter *waiter);
+
+private:
+  struct Slot {
+    std::atomic<size_t> seq;
+    Message message;
+  };
+
+  static constexpr size_t CLOSED_BIT = ~(SIZE_MAX >> 1);
+
+  bool take(Message &message);
+  void notify();
+
+  std::unique_ptr<Slot[]> slots;
+  const size_t mask;
+  const size_t capacity;
+  // producers and consumers on separate cache lines
+  alignas(64) std::atomic<size_t> enqueue_pos{0}; // with CLOSED_BIT
+  alignas(64) std::atomic<size_t> dequeue_pos{0};
+  alignas(64) std::atomic<int> waiter_count{0};
+  std::mutex waiters_mutex;
+  std::vector<Waiter *> waiters;
+};
+
+// Channel.new(capacity): a script's handle of a ChannelQueue
+class Channel : public Object {
+public:
+  Channel(std::shared_ptr<ChannelQueue> queue);
+
+  static bool is_channel(const Value &v) {
+    return v.type == Type::OBJECT && v.objval->klass == Klass::Channel;
+  }
+
+  const std::shared_ptr<ChannelQueue> &get_queue() const { return queue; }
+
+  virtual const std::string to_s() { return "<Channel>"; }
+
+  // select(channels...): [index, value] of the first channel, in argument
+  // order, with a message, or with false for one closed and drained
+  static Value select(Value *channels, int count);
+
+  static void init();
+
+private:
+  std::shared_ptr<ChannelQueue> queue;
+};
+} // namespace holang
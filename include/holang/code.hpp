@@ -1,79 +1,131 @@
 #pragma once
 
 #include "holang/instruction.hpp"
+#include <cstdint>
+#include <cstring>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace holang {
 class Object;
 struct Func;
 
+// an entry of the constant table of a CodeSequence
 union Code {
-  Instruction op;
-  int ival;
+  int64_t ival;
   double dval;
-  bool bval;
   std::string *sval;
   Func *funcval;
   Object *objval;
 };
 
+/*
+ * Bytecode of a module, a func or a block.
+ *
+ * An instruction is one byte followed by operand_count() operands of
+ * OPERAND_SIZE bytes each, in native byte order and unaligned. Jump
+ * targets, local indices, counts and bools are stored in the operand.
+ * Int and double literals, names and funcs go to the sequence's constant
+ * table and the operand is their index (see is_constant_operand()). Program
+ * counters and jump targets are byte offsets.
+ */
+static_assert(INSTRUCTION_SIZE <= 256, "an instruction takes one byte");
+
 class CodeSequence {
 public:
+  static constexpr int OPERAND_SIZE = 4;
+
   CodeSequence() {}
   CodeSequence(const CodeSequence &src)
-      : source_path(src.source_path), sequence(src.sequence) {}
+      : source_path(src.source_path), max_stack(src.max_stack),
+        bytes(src.bytes), constants(src.constants) {}
+  CodeSequence(CodeSequence &&src)
+      : source_path(src.source_path), max_stack(src.max_stack),
+        bytes(std::move(src.bytes)), constants(std::move(src.constants)) {}
   CodeSequence(const std::string &source_path) : source_path(source_path) {}
 
-  void append(Instruction op) {
-    Code code;
-    code.op = op;
-    sequence.push_back(code);
+  void append(Instruction op) { bytes.push_back(static_cast<uint8_t>(op)); }
+
+  // operands stored in the instruction
+  void append(int32_t i) {
+    size_t at = bytes.size();
+    bytes.resize(at + OPERAND_SIZE);
+    patch(at, i);
   }
+  void append(bool b) { append(static_cast<int32_t>(b)); }
 
-  void append(int ival) {
+  // operands in the constant table
+  void append(int64_t ival) {
     Code code;
     code.ival = ival;
-    sequence.push_back(code);
+    append_constant(code);
   }
-
   void append(double dval) {
     Code code;
     code.dval = dval;
-    sequence.push_back(code);
+    append_constant(code);
   }
-
-  void append(bool bval) {
-    Code code;
-    code.bval = bval;
-    sequence.push_back(code);
-  }
-
   void append(std::string *sval) {
     Code code;
     code.sval = sval;
-    sequence.push_back(code);
+    append_constant(code);
   }
-
   void append(Func *f) {
     Code code;
     code.funcval = f;
-    sequence.push_back(code);
+    append_constant(code);
   }
-
   void append(Object *o) {
     Code code;
     code.objval = o;
-    sequence.push_back(code);
+    append_constant(code);
+  }
+
+  // an operand in the constant table, e.g. one copied from another sequence
+  void append_constant(const Code &code) {
+    append(static_cast<int32_t>(constants.size()));
+    constants.push_back(code);
+  }
+
+  // Sets the operand at byte offset `at`, e.g. a jump target appended
+  // before the target was known.
+  void patch(size_t at, int32_t i) {
+    std::memcpy(&bytes[at], &i, OPERAND_SIZE);
   }
 
-  std::vector<Code> get_sequence() const { return sequence; }
-  size_t size() const { return sequence.size(); }
-  Code &at(size_t index) { return sequence[index]; }
+  size_t size() const { return bytes.size(); }
+  Instruction op_at(size_t pc) const {
+    return static_cast<Instruction>(bytes[pc]);
+  }
+  int32_t int_at(size_t at) const {
+    int32_t i;
+    std::memcpy(&i, &bytes[at], OPERAND_SIZE);
+    return i;
+  }
+  // the constant whose index is the operand at `at`
+  const Code &constant_at(size_t at) const { return constants[int_at(at)]; }
+
+  const std::vector<uint8_t> &get_bytes() const { return bytes; }
+  const std::vector<Code> &get_constants() const { return constants; }
+  // replaces the code, e.g. by one read from a snapshot
+  void assign(std::vector<uint8_t> &&code, std::vector<Code> &&table) {
+    bytes = std::move(code);
+    constants = std::move(table);
+  }
 
   const std::string source_path;
+  // values the code pushes on top of its frame at most, set by the
+  // Verifier; -1 until verified
+  int max_stack = -1;
 
 private:
-  std::vector<Code> sequence;
+  std::vector<uint8_t> bytes;
+  std::vector<Code> constants;
 };
+
+// bytes taken by an instruction and its operands
+inline size_t encoded_size(Instruction op) {
+  return 1 + operand_count(op) * CodeSequence::OPERAND_SIZE;
+}
 } // namespace holang
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "holang/object.hpp"
+#include "holang/value.hpp"
+#include <memory>
+#include <vector>
+
+namespace holang {
+class HolangVM;
+
+/*
+ * Coroutine running a func whose body yields, or a block given to
+ * `coroutine { |args| ... }`.
+ *
+ * It owns a VM of its own, i.e. a separate value stack and frame list, so
+ * suspending at a yield only leaves that VM's eval loop; nothing is kept on
+ * the C++ stack between a yield and the next resume. A yield inside a block
+ * called by a native (e.g. Array#each) can not be suspended and is an
+ * error; loops compiled inline (for, times, upto) can yield.
+ */
+class Coroutine : public Object {
+public:
+  Coroutine(Func *func, Value self, Value *args, int argc);
+  ~Coroutine();
+
+  static bool is_coroutine(const Value &v) {
+    return v.type == Type::OBJECT && v.objval->klass == Klass::Coroutine;
+  }
+
+  // Runs until the next yield or the end of the body. The first resume
+  // appends `args` to the arguments of the func; later ones make args[0]
+  // the value of the suspended yield expression. Returns true with the
+  // yielded value in `out`, or false with the returned value once the
+  // coroutine has finished.
+  bool resume(Value *args, int argc, Value &out);
+  bool is_done() const { return done; }
+  // the returned value once is_done()
+  Value get_value() const { return value; }
+  // nullptr until the first resume and after the end
+  HolangVM *get_vm() const { return vm.get(); }
+
+  virtual const std::string to_s() { return "<Coroutine>"; }
+
+  static void init();
+
+private:
+  Func *func;
+  Value self;
+  std::vector<Value> args;
+  std::unique_ptr<HolangVM> vm; // created by the first resume
+  bool running = false;
+  bool done = false;
+  Value value;
+};
+} // namespace holang
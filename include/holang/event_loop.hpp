@@ -0,0 +1,141 @@
+#pragma once
+
+#include "holang/object.hpp"
+#include "holang/value.hpp"
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace holang {
+class Coroutine;
+class Stream;
+
+/*
+ * epoll event loop running the coroutines started by
+ * `async(args...) { |params| ... }`.
+ *
+ * IO.run() resumes the started coroutines ("tasks") one at a time on the
+ * calling thread. When a task reads, writes, accepts or connects on a
+ * Stream which is not ready, or sleeps, the native registers what the task
+ * waits for and suspends it as if it had yielded. Once epoll reports the
+ * descriptor ready (or the timer expires) the loop performs the operation
+ * itself and resumes the task with the result, which becomes the value of
+ * the native call. Descriptors are registered edge-triggered once and stay
+ * registered until they are closed, so a wait costs no epoll_ctl.
+ *
+ * Outside a task, or inside a block called by a native, the same methods
+ * block the thread instead.
+ */
+class EventLoop {
+public:
+  enum class Op { READ, WRITE, ACCEPT, CONNECT };
+
+  // an operation on a Stream, retried until it completes
+  struct Wait {
+    Coroutine *task = nullptr;
+    Stream *stream = nullptr;
+    Op op = Op::READ;
+    std::string data; // bytes left to write
+    int64_t written = 0;
+  };
+
+  EventLoop();
+  ~EventLoop();
+  EventLoop(const EventLoop &) = delete;
+  EventLoop &operator=(const EventLoop &) = delete;
+
+  // queues a new coroutine to be started by run()
+  void start(Coroutine *task);
+  // Runs until every started task has finished.
+  void run();
+
+  // The loop of the current isolate when the code running on this thread
+  // is one of its tasks and can be suspended; nullptr otherwise.
+  static EventLoop *suspendable();
+  // Suspends the running task until `wait` completes; suspendable() must
+  // have returned this loop.
+  void suspend(Wait &&wait);
+  void suspend_for(std::chrono::milliseconds duration);
+  // Drops the descriptor from epoll before it is closed. Tasks waiting on
+  // it are resumed with false.
+  void forget(int fd);
+
+  // Makes one attempt at the operation. Returns false if it would block.
+  static bool attempt(Wait &wait, Value &result);
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Ready {
+    Coroutine *task;
+    Value value;
+    int argc; // 0 when the task has not started yet
+  };
+  struct Watch {
+    Wait reader; // READ or ACCEPT
+    Wait writer; // WRITE or CONNECT
+  };
+  struct Timer {
+    Clock::time_point deadline;
+    uint64_t seq; // keeps timers with the same deadline in order
+    Coroutine *task;
+    bool operator>(const Timer &other) const {
+      return deadline != other.deadline ? deadline > other.deadline
+                                        : seq > other.seq;
+    }
+  };
+
+  void resume(Ready &ready);
+  void poll(int timeout_ms);
+  void complete(Wait &wait);
+  void expire_timers();
+  int next_timeout() const;
+
+  int epoll_fd;
+  std::deque<Ready> ready;
+  std::unordered_map<int, Watch> watches;
+  std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers;
+  uint64_t timer_seq = 0;
+  // started tasks which have not finished
+  int64_t tasks = 0;
+  // suspended tasks waiting on a descriptor
+  int64_t waiting = 0;
+  Coroutine *running_task = nullptr;
+  bool task_suspended = false;
+  bool running = false;
+};
+
+// A non-blocking file descriptor: a socket or an end of a pipe.
+class Stream : public Object {
+public:
+  Stream(int fd, bool socket);
+
+  static bool is_stream(const Value &v) {
+    return v.type == Type::OBJECT && v.objval->klass == Klass::Stream;
+  }
+
+  int get_fd() const { return fd; }
+  bool is_socket() const { return socket; }
+  void close();
+
+  virtual const std::string to_s() { return "<Stream>"; }
+
+private:
+  int fd;
+  bool socket;
+};
+
+/*
+ * IO module: IO.listen(port), IO.connect(port), IO.pipe() and IO.run().
+ * Sockets are TCP on the loopback interface.
+ */
+class IO {
+public:
+  static void init();
+};
+} // namespace holang
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "holang/object.hpp"
+#include "holang/output.hpp"
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace holang {
+class Isolate;
+
+// Contents of the file at `path`. A regular file is mapped read-only and
+// the mapping lives as long as `data`; anything else is read into memory.
+// Returns false when the file can not be opened.
+bool load_file(const std::string &path, std::shared_ptr<const char> &data,
+               size_t &size);
+
+/*
+ * File module: File.read(path), File.mmap(path), File.each_line(path)
+ * { |line| }, File.write(path, values...) and File.create(path).
+ */
+class File {
+public:
+  static void init();
+};
+
+// Writer returned by File.create(path). Output is buffered in large blocks
+// and flushed on close() or when its isolate is flushed.
+class FileWriter : public Object {
+public:
+  FileWriter(int fd);
+
+  static bool is_file_writer(const Value &v) {
+    return v.type == Type::OBJECT && v.objval->klass == Klass::FileWriter;
+  }
+
+  void close();
+  OutputBuffer *get_buffer() { return out.get(); }
+
+  virtual const std::string to_s() { return "<FileWriter>"; }
+
+private:
+  int fd;
+  Isolate *isolate;
+  std::unique_ptr<OutputBuffer> out;
+};
+} // namespace holang
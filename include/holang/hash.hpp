@@ -0,0 +1,77 @@
+#pragma once
+
+#include "holang/object.hpp"
+#include "holang/value.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace holang {
+/*
+ * Hash table keyed by Int or String.
+ *
+ * Entries (key, value and the key's hash) are kept in a dense vector in
+ * insertion order, which is also the iteration order. The index over them is
+ * an open-addressing table in the style of SwissTable: one control byte per
+ * slot holding 7 bits of the hash (or EMPTY / DELETED), probed 16 slots at a
+ * time with SIMD compares, and a parallel array of entry positions. Erased
+ * entries stay in the vector until they outnumber the live ones.
+ */
+class Hash : public Object {
+public:
+  struct Entry {
+    Value key;
+    Value value;
+    uint64_t hash;
+    bool live;
+  };
+
+  Hash() { klass = Klass::Hash; }
+
+  static bool is_hash(const Value &v) {
+    return v.type == Type::OBJECT && v.objval->klass == Klass::Hash;
+  }
+
+  // pointer to the value for `key`, or nullptr when it is absent
+  Value *find(const Value &key);
+  void insert(const Value &key, const Value &value);
+  bool erase(const Value &key);
+  size_t size() const { return count; }
+
+  // entries in insertion order; skip the ones which are not live
+  const std::vector<Entry> &get_entries() const { return entries; }
+
+  // Keeps every entry at its position in get_entries() while it lives, for
+  // code which may insert or erase while it iterates: erased entries are
+  // not compacted away, and inserted ones are appended.
+  class Pin {
+  public:
+    explicit Pin(Hash *hash) : hash(hash) { hash->pins++; }
+    ~Pin() { hash->pins--; }
+    Pin(const Pin &) = delete;
+    Pin &operator=(const Pin &) = delete;
+
+  private:
+    Hash *hash;
+  };
+
+  virtual const std::string to_s();
+  virtual void write_to(OutputBuffer &out);
+
+  static void init();
+
+private:
+  // position in `entries` or -1
+  int64_t find_entry(const Value &key, uint64_t hash) const;
+  // slot for a new key: the first EMPTY or DELETED one on its probe sequence
+  size_t find_insert_slot(uint64_t hash) const;
+  void set_ctrl(size_t slot, uint64_t hash, uint32_t entry);
+  void rehash(size_t new_capacity);
+
+  std::vector<int8_t> ctrl;
+  std::vector<uint32_t> slots;
+  std::vector<Entry> entries;
+  size_t count = 0;       // live entries
+  size_t growth_left = 0; // EMPTY slots which may still be filled
+  int pins = 0;
+};
+} // namespace holang
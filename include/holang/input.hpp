@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace holang {
+class String;
+
+/*
+ * Block reader over a file descriptor.
+ *
+ * A regular file is mapped into memory as a whole and the strings read from
+ * it are views of the mapping. Anything else (pipes, TTYs) is read in large
+ * blocks; the unread tail of a block is moved to the
+ * front of the buffer before the next read so that a token is always
+ * contiguous. Numbers are parsed straight from the buffer.
+ */
+class InputBuffer {
+public:
+  InputBuffer(int fd, size_t capacity = 1 << 16);
+  ~InputBuffer();
+  InputBuffer(const InputBuffer &) = delete;
+  InputBuffer &operator=(const InputBuffer &) = delete;
+
+  // Skips whitespace and reads a decimal integer. Returns false at EOF.
+  bool read_int(int64_t &out);
+  // Skips whitespace and reads a whitespace-delimited word.
+  String *read_word();
+  // Reads up to the end of line. The line terminator is not included.
+  String *read_line();
+  // Returns true when only whitespace is left.
+  bool eof();
+
+private:
+  int peek() {
+    if (cur == end && !fill()) {
+      return -1;
+    }
+    return static_cast<unsigned char>(*cur);
+  }
+  bool skip_space();
+  bool fill() {
+    const char *nothing = end;
+    return fill(nothing);
+  }
+  String *make_string(const char *first, const char *last);
+  // Reads the next block, keeping [keep, end) in the buffer. `keep` is
+  // updated to point at the same bytes after they are moved.
+  bool fill(const char *&keep);
+
+  const int fd;
+  char *buf = nullptr;
+  size_t capacity;
+  const char *cur = nullptr;
+  const char *end = nullptr;
+  std::shared_ptr<const char> mapped;
+  bool at_eof = false;
+};
+
+// reader of the standard input of the current isolate
+InputBuffer &standard_input();
+} // namespace holang
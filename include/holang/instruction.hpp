@@ -7,6 +7,7 @@ namespace holang {
 enum class Instruction {
   PUT_ENV,
   PUT_INT,
+  PUT_DOUBLE,
   PUT_BOOL,
   PUT_STRING,
   PUT_LAMBDA,
@@ -32,6 +33,83 @@ enum class Instruction {
   PREV_ENV,
   LOAD_OBJ_FIELD,
   IMPORT,
+  NEW_ARRAY,
+  IDX_LOAD,
+  IDX_STORE,
+  CONCAT,
+  NEW_RANGE,
+  LOOP_PREP,
+  LOOP_STEP,
+  YIELD,
+  MAKE_CELL,
+  LOAD_CELL,
+  STORE_CELL,
+  MAKE_CLOSURE,
+};
+
+// Number of instructions. Keep in sync with the last entry of Instruction.
+constexpr size_t INSTRUCTION_SIZE =
+    static_cast<size_t>(Instruction::MAKE_CLOSURE) + 1;
+
+// Number of operands following the instruction in a CodeSequence.
+inline int operand_count(Instruction op) {
+  switch (op) {
+  case Instruction::PUT_INT:
+  case Instruction::PUT_DOUBLE:
+  case Instruction::PUT_BOOL:
+  case Instruction::PUT_STRING:
+  case Instruction::PUT_LAMBDA:
+  case Instruction::STORE_LOCAL:
+  case Instruction::LOAD_LOCAL:
+  case Instruction::JUMP:
+  case Instruction::JUMP_IF:
+  case Instruction::JUMP_IFNOT:
+  case Instruction::LOAD_CLASS:
+  case Instruction::LOAD_OBJ_FIELD:
+  case Instruction::NEW_ARRAY:
+  case Instruction::CONCAT:
+  case Instruction::MAKE_CELL:
+  case Instruction::LOAD_CELL:
+  case Instruction::STORE_CELL:
+  case Instruction::MAKE_CLOSURE:
+    return 1;
+  case Instruction::CALL_FUNC: // name, argc
+  case Instruction::DEF_FUNC:  // name, func
+    return 2;
+  case Instruction::LOOP_STEP: // var, slot, body_pc
+    return 3;
+  case Instruction::LOOP_PREP: // kind, var, slot, exit_pc, fallback_pc
+    return 5;
+  default:
+    return 0;
+  }
+}
+
+// Whether operand `i` of `op` is an index into the constant table of its
+// CodeSequence rather than the value itself.
+inline bool is_constant_operand(Instruction op, int i) {
+  switch (op) {
+  case Instruction::PUT_INT:        // int64
+  case Instruction::PUT_DOUBLE:     // double
+  case Instruction::PUT_STRING:     // std::string *
+  case Instruction::LOAD_CLASS:     // std::string *
+  case Instruction::LOAD_OBJ_FIELD: // std::string *
+  case Instruction::PUT_LAMBDA:     // Func *
+  case Instruction::MAKE_CLOSURE:   // Func *
+  case Instruction::DEF_FUNC:       // std::string *, Func * as Object *
+    return true;
+  case Instruction::CALL_FUNC: // std::string *, argc
+    return i == 0;
+  default:
+    return false;
+  }
+}
+
+// What LOOP_PREP takes from the stack.
+enum class LoopKind {
+  TIMES,    // [n]: 0 up to n - 1
+  BOUNDS,   // [first, last]: first up to last
+  ITERABLE, // [range, array or coroutine]
 };
 
 static std::ostream &operator<<(std::ostream &out,
@@ -41,6 +119,8 @@ static std::ostream &operator<<(std::ostream &out,
     return out << "PUT_ENV";
   case Instruction::PUT_INT:
     return out << "PUT_INT";
+  case Instruction::PUT_DOUBLE:
+    return out << "PUT_DOUBLE";
   case Instruction::PUT_BOOL:
     return out << "PUT_BOOL";
   case Instruction::PUT_STRING:
@@ -91,6 +171,30 @@ static std::ostream &operator<<(std::ostream &out,
     return out << "LOAD_OBJ_FIELD";
   case Instruction::IMPORT:
     return out << "IMPORT";
+  case Instruction::NEW_ARRAY:
+    return out << "NEW_ARRAY";
+  case Instruction::IDX_LOAD:
+    return out << "IDX_LOAD";
+  case Instruction::IDX_STORE:
+    return out << "IDX_STORE";
+  case Instruction::CONCAT:
+    return out << "CONCAT";
+  case Instruction::NEW_RANGE:
+    return out << "NEW_RANGE";
+  case Instruction::LOOP_PREP:
+    return out << "LOOP_PREP";
+  case Instruction::LOOP_STEP:
+    return out << "LOOP_STEP";
+  case Instruction::YIELD:
+    return out << "YIELD";
+  case Instruction::MAKE_CELL:
+    return out << "MAKE_CELL";
+  case Instruction::LOAD_CELL:
+    return out << "LOAD_CELL";
+  case Instruction::STORE_CELL:
+    return out << "STORE_CELL";
+  case Instruction::MAKE_CLOSURE:
+    return out << "MAKE_CLOSURE";
   }
 }
 } // namespace holang
@@ -0,0 +1,154 @@
+#pragma once
+
+#include "holang/input.hpp"
+#include "holang/object.hpp"
+#include "holang/output.hpp"
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace holang {
+class EventLoop;
+class FileWriter;
+class Scheduler;
+
+/*
+ * Runtime context of an interpreter.
+ *
+ * An isolate owns everything a running script can change: the builtin
+ * classes (scripts may reopen them), the main object holding top-level
+ * functions, the import search path, the standard input and output buffers
+ * and the open files. Isolates share nothing, so each of them can run on
+ * its own thread.
+ *
+ * A thread works in an isolate while an Isolate::Scope is alive; Klass::Int
+ * and the other builtin classes then refer to that isolate's classes. Apart
+ * from the workers of its own scheduler, an isolate must not be entered by
+ * two threads at once.
+ */
+class Isolate {
+public:
+  Isolate(int in_fd = STDIN_FILENO, int out_fd = STDOUT_FILENO);
+  ~Isolate();
+  Isolate(const Isolate &) = delete;
+  Isolate &operator=(const Isolate &) = delete;
+
+  // the isolate entered by this thread, or nullptr
+  static Isolate *current() { return entered; }
+
+  class Scope {
+  public:
+    Scope(Isolate *isolate);
+    ~Scope();
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+  private:
+    Isolate *outer;
+  };
+
+  OutputBuffer &output() { return out; }
+  // created on first use, by whichever thread reads first
+  InputBuffer &input();
+
+  // Serializes writes to the output once spawned tasks may print from
+  // worker threads; free before that.
+  class OutputLock {
+  public:
+    OutputLock() : isolate(current()) {
+      if (isolate != nullptr && isolate->threaded) {
+        isolate->output_mutex.lock();
+      } else {
+        isolate = nullptr;
+      }
+    }
+    ~OutputLock() {
+      if (isolate != nullptr) {
+        isolate->output_mutex.unlock();
+      }
+    }
+    OutputLock(const OutputLock &) = delete;
+    OutputLock &operator=(const OutputLock &) = delete;
+
+  private:
+    Isolate *isolate;
+  };
+
+  // Serializes reads of the input from worker threads, as OutputLock does
+  // for writes.
+  class InputLock {
+  public:
+    InputLock() : isolate(current()) {
+      if (isolate != nullptr && isolate->threaded) {
+        isolate->input_mutex.lock();
+      } else {
+        isolate = nullptr;
+      }
+    }
+    ~InputLock() {
+      if (isolate != nullptr) {
+        isolate->input_mutex.unlock();
+      }
+    }
+    InputLock(const InputLock &) = delete;
+    InputLock &operator=(const InputLock &) = delete;
+
+  private:
+    Isolate *isolate;
+  };
+
+  // workers of spawn { }, started on first use
+  Scheduler &scheduler();
+  // loop of the tasks started by async { }, created on first use
+  EventLoop &event_loop();
+
+  // Flushes the output and closes the open files. Also done at exit for
+  // the isolates still alive.
+  void flush();
+
+  // set up by the first VM created in the isolate
+  Object *main_obj = nullptr;
+  std::vector<std::string> import_search_path;
+  // tracks the FileWriters which are not closed yet, from any thread
+  void add_writer(FileWriter *writer);
+  void remove_writer(FileWriter *writer);
+
+private:
+  static void enter(Isolate *isolate);
+
+  static thread_local Isolate *entered;
+
+  Klass int_klass{"Int"};
+  Klass double_klass{"Double"};
+  Klass bigint_klass{"Int"};
+  Klass string_klass{"String"};
+  Klass array_klass{"Array"};
+  Klass hash_klass{"Hash"};
+  Klass string_builder_klass{"StringBuilder"};
+  Klass range_klass{"Range"};
+  Klass lazy_klass{"Lazy"};
+  Klass file_klass{"File"};
+  Klass file_writer_klass{"FileWriter"};
+  Klass future_klass{"Future"};
+  Klass coroutine_klass{"Coroutine"};
+  Klass io_klass{"IO"};
+  Klass stream_klass{"Stream"};
+  Klass channel_klass{"Channel"};
+
+  const int in_fd;
+  std::once_flag in_created;
+  std::unique_ptr<InputBuffer> in;
+  std::mutex input_mutex;
+  OutputBuffer out;
+  std::mutex output_mutex;
+  // true once worker threads may run in this isolate
+  bool threaded = false;
+  std::unique_ptr<Scheduler> workers;
+  std::unique_ptr<EventLoop> loop;
+  std::mutex writers_mutex;
+  std::set<FileWriter *> open_writers;
+};
+} // namespace holang
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdio>
+#include <ostream>
+#include <string>
+
+namespace holang {
+static void write_json_string(std::ostream &out, const std::string &str) {
+  out << '"';
+  for (char c : str) {
+    if (c == '"' || c == '\\') {
+      out << '\\' << c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char buf[8];
+      snprintf(buf, sizeof(buf), "\\u%04x", c);
+      out << buf;
+    } else {
+      out << c;
+    }
+  }
+  out << '"';
+}
+} // namespace holang
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "holang/object.hpp"
+#include "holang/value.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace holang {
+/*
+ * Lazy enumerator over an Array, a Range or a Coroutine.
+ *
+ * `xs.lazy().map { }.filter { }.take(10)` only records the stages; each of
+ * them returns a new Lazy, so a pipeline can be shared and extended. The
+ * consumers (each, to_a, sum, first) run all stages in one loop per source
+ * element without building a collection between them.
+ */
+class Lazy : public Object {
+public:
+  enum class Stage { MAP, FILTER, REJECT, TAKE, TAKE_WHILE };
+  struct Step {
+    Stage stage;
+    Func *func; // nullptr for TAKE
+    int64_t count;
+  };
+
+  Lazy(Value source) : source(source) { klass = Klass::Lazy; }
+
+  static bool is_lazy(const Value &v) {
+    return v.type == Type::OBJECT && v.objval->klass == Klass::Lazy;
+  }
+
+  // feeds every value coming out of the last stage to `sink`, which returns
+  // false to stop early
+  template <typename Sink> void run(Sink sink);
+
+  virtual const std::string to_s() { return "<Lazy>"; }
+
+  static void init();
+
+  const Value source;
+  std::vector<Step> steps;
+};
+} // namespace holang
@@ -8,8 +8,11 @@
 namespace holang {
 class Lexer {
 public:
-  Lexer() { init_keywords(); }
-  Lexer(const std::string &str) : code_str(str) { init_keywords(); }
+  Lexer() {}
+  Lexer(const std::string &str)
+      : owned_code(str), code(owned_code.data()), code_size(str.size()) {}
+  // lexes [code, code + size) in place; it has to outlive lex()
+  Lexer(const char *code, size_t size) : code(code), code_size(size) {}
   void lex(std::vector<Token *> &token_chain);
 
 private:
@@ -23,7 +26,8 @@ private:
 
   Token *read_number(char c);
   Token *read_ident(char c);
-  Token *read_str();
+  // `continued` is true after the "}" closing an interpolation
+  Token *read_str(bool continued = false);
 
   void skip_blank();
   void skip_to_newline();
@@ -32,13 +36,17 @@ private:
   void invalid(char c) const;
 
 private:
-  static std::map<std::string, TokenType> keywords;
-  static void init_keywords();
+  // built once and shared by the lexers of all threads
+  static const std::map<std::string, TokenType> &keywords();
 
-  std::string code_str;
+  std::string owned_code;
+  const char *code = nullptr;
+  size_t code_size = 0;
   size_t head = 0;
   size_t line = 0;
   size_t line_begin_at = 0;
   size_t token_begin_at = 0;
+  // nesting depth of "{" inside each open "#{" interpolation
+  std::vector<int> interpolations;
 };
 } // namespace holang
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "holang/code.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace holang {
+// Size and modification time of a source file, recorded in its snapshot.
+struct SourceStamp {
+  uint64_t size = 0;
+  int64_t mtime_ns = 0;
+
+  // false when the file does not exist
+  static bool of(const std::string &path, SourceStamp &out);
+  bool operator==(const SourceStamp &other) const {
+    return size == other.size && mtime_ns == other.mtime_ns;
+  }
+};
+
+/*
+ * Compiled source file: its top-level code, ending with RET, and the
+ * number of its top-level locals.
+ *
+ * Module::load() keeps every module compiled in the process and hands it
+ * out again while the file is unchanged, so importing a module twice, or
+ * from several isolates, compiles it once. Before compiling, it looks for
+ * a snapshot of the file, a binary image of the bytecode written by
+ * `ho FILE --snapshot=OUT`: FILE with a "c" appended (x.ho -> x.hoc), or
+ * for holib modules the snapshot the build writes. A snapshot is mmap'd
+ * and decoded without lexing or parsing, and used only if it records the
+ * current size and mtime of the source and this build's instruction set.
+ */
+class Module {
+public:
+  explicit Module(const std::string &path) : codes(path) {}
+
+  // Lexes, parses and generates code; exits on a syntax error. The module
+  // is owned by the caller.
+  static Module *compile(const char *source, size_t size,
+                         const std::string &path);
+  static Module *compile(const std::string &source, const std::string &path) {
+    return compile(source.data(), source.size(), path);
+  }
+  // The module of the file at `path`, compiled or cached. Exits when the
+  // file can not be read.
+  static const Module *load(const std::string &path);
+
+  // `name` as found in the current directory or under a search path entry
+  // (the entries win unless `name` starts with '.'), trying `name` and
+  // then `name`.ho. Returns `name` itself when nothing exists.
+  static std::string resolve(const std::string &name,
+                             const std::vector<std::string> &search_path);
+
+  std::string snapshot(const SourceStamp &stamp) const;
+  // nullptr when `data` is not a snapshot of this build matching `stamp`
+  static Module *from_snapshot(const char *data, size_t size,
+                               const std::string &path,
+                               const SourceStamp &stamp);
+
+  CodeSequence codes;
+  int local_size = 0;
+};
+} // namespace holang
@@ -4,6 +4,7 @@
 #include "holang/instruction.hpp"
 #include "holang/object.hpp"
 #include "holang/token.hpp"
+#include "holang/variable_table.hpp"
 #include <vector>
 
 namespace holang {
@@ -27,12 +28,22 @@ static void print_offset(int offset) {
 
 struct IntLiteralNode : public Node {
 public:
-  IntLiteralNode(int value) : value(value){};
+  IntLiteralNode(int64_t value) : value(value){};
   void print(int offset) override;
   void code_gen(CodeSequence *codes) override;
 
 private:
-  const int value;
+  const int64_t value;
+};
+
+struct DoubleLiteralNode : public Node {
+public:
+  DoubleLiteralNode(double value) : value(value){};
+  void print(int offset) override;
+  void code_gen(CodeSequence *codes) override;
+
+private:
+  const double value;
 };
 
 struct BoolLiteralNode : public Node {
@@ -55,30 +66,78 @@ private:
   std::string str; // want to be const
 };
 
+struct InterpolationNode : public Node {
+public:
+  InterpolationNode(const vector<Node *> &parts) : parts(parts) {}
+  void print(int offset) override;
+  void code_gen(CodeSequence *codes) override;
+
+private:
+  const vector<Node *> parts;
+};
+
+struct ArrayLiteralNode : public Node {
+public:
+  ArrayLiteralNode(const vector<Node *> &elements) : elements(elements) {}
+  void print(int offset) override;
+  void code_gen(CodeSequence *codes) override;
+
+private:
+  const vector<Node *> elements;
+};
+
 struct IdentNode : public Node {
 public:
-  IdentNode(const string &ident, int depth, int index)
-      : ident(ident), depth(depth), index(index) {}
+  IdentNode(const VariableTable::Variable *var, int depth)
+      : ident(var->name), depth(depth), index(var->index), var(var) {}
   void print(int offset) override;
   void code_gen(CodeSequence *codes) override;
 
   // TODO
   // private:
   const std::string ident;
+  // blocks between the frame of the variable and the one using it, which
+  // reaches it through the cell in its own slot `index`
   const int depth;
   const int index;
+  const VariableTable::Variable *var;
 };
 
 struct LambdaNode : public Node {
 public:
-  LambdaNode(const vector<string *> &params, Node *body)
-      : params(params), body(body) {}
+  LambdaNode(const vector<string *> &params, Node *body, int local_size,
+             const vector<pair<int, int>> &captures)
+      : params(params), body(body), local_size(local_size),
+        captures(captures) {}
   void print(int offset) override;
   void code_gen(CodeSequence *codes) override;
 
+  const vector<string *> &get_params() const { return params; }
+  Node *get_body() const { return body; }
+  // slots of its frame: self, the params, its locals and its captures
+  int get_local_size() const { return local_size; }
+  // see Func::captures
+  const vector<pair<int, int>> &get_captures() const { return captures; }
+
 private:
   vector<string *> params;
   Node *body;
+  int local_size;
+  vector<pair<int, int>> captures;
+};
+
+// The body of a func, a block or the top level, some of whose variables
+// blocks captured: their slots get a Cell when the frame is entered.
+struct MakeCellsNode : public Node {
+public:
+  MakeCellsNode(const vector<int> &slots, Node *body)
+      : slots(slots), body(body) {}
+  void print(int offset) override;
+  void code_gen(CodeSequence *codes) override;
+
+private:
+  const vector<int> slots;
+  Node *body;
 };
 
 struct BinopNode : public Node {
@@ -146,6 +205,57 @@ private:
   Node *cond, *body;
 };
 
+struct RangeNode : public Node {
+public:
+  RangeNode(Node *first, Node *last) : first(first), last(last) {}
+  void print(int offset) override;
+  void code_gen(CodeSequence *codes) override;
+
+  Node *const first;
+  Node *const last;
+};
+
+// for var in iterable { body }
+// `slot` and `slot + 1` are hidden locals holding the loop state, and
+// `slot + 2` the element when blocks captured the variable.
+struct ForNode : public Node {
+public:
+  ForNode(const VariableTable::Variable *var, int slot, Node *iterable,
+          Node *body)
+      : var(var), slot(slot), iterable(iterable), body(body) {}
+  void print(int offset) override;
+  void code_gen(CodeSequence *codes) override;
+
+private:
+  const VariableTable::Variable *var;
+  int slot;
+  Node *iterable;
+  Node *body;
+};
+
+// n.times() { |i| ... } or a.upto(b) { |i| ... } with a literal block. The
+// block body is compiled inline as a counted loop over locals of the
+// enclosing frame; when the receiver or the argument of upto is not an Int,
+// or a script redefined Int#times or Int#upto, the block is called through
+// the method as usual.
+struct LoopCallNode : public Node {
+public:
+  LoopCallNode(const string &name, const vector<Node *> &args,
+               LambdaNode *block, int base, int slot, bool self_is_main)
+      : name(name), args(args), block(block), base(base), slot(slot),
+        self_is_main(self_is_main) {}
+  void print(int offset) override;
+  void code_gen(CodeSequence *codes) override;
+
+private:
+  string name;
+  const vector<Node *> args;
+  LambdaNode *block;
+  int base; // slot 1 of the block's frame in the current one
+  int slot; // the counter, followed by the limit
+  bool self_is_main;
+};
+
 struct FuncCallNode : public Node {
 public:
   FuncCallNode(const string &name, const vector<Node *> &args, bool is_trailer)
@@ -162,8 +272,10 @@ private:
 
 struct FuncDefNode : public Node {
 public:
-  FuncDefNode(const string &name, const vector<string *> &params, Node *body)
-      : name(name), params(params), body(body) {}
+  FuncDefNode(const string &name, const vector<string *> &params, Node *body,
+              int local_size, bool generator = false)
+      : name(name), params(params), body(body), local_size(local_size),
+        generator(generator) {}
   void print(int offset) override;
   void code_gen(CodeSequence *codes) override;
 
@@ -171,6 +283,9 @@ private:
   string name;
   vector<string *> params;
   Node *body;
+  int local_size;
+  // the body yields: a call returns a Coroutine
+  bool generator;
 };
 
 struct KlassDefNode : public Node {
@@ -205,6 +320,27 @@ private:
   Node *traier;
 };
 
+struct IndexNode : public Node {
+public:
+  IndexNode(Node *recv, Node *index) : recv(recv), index(index) {}
+  void print(int offset) override;
+  void code_gen(CodeSequence *codes) override;
+
+  Node *const recv;
+  Node *const index;
+};
+
+struct IndexAssignNode : public Node {
+public:
+  IndexAssignNode(IndexNode *lhs, Node *rhs) : lhs(lhs), rhs(rhs) {}
+  void print(int offset) override;
+  void code_gen(CodeSequence *codes) override;
+
+private:
+  IndexNode *lhs;
+  Node *rhs;
+};
+
 struct RefFieldNode : public Node {
 public:
   RefFieldNode(const string &field) : field(field) {}
@@ -225,6 +361,16 @@ private:
   Node *module;
 };
 
+struct YieldNode : public Node {
+public:
+  YieldNode(Node *expr) : expr(expr) {}
+  void print(int offset) override;
+  void code_gen(CodeSequence *codes) override;
+
+private:
+  Node *expr; // nullptr for a bare yield
+};
+
 struct ReturnNode : public Node {
 public:
   ReturnNode(Node *expr) : expr(expr) {}
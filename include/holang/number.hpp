@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace holang {
+// Buffer sizes which are always enough for format_int() and format_double().
+constexpr size_t INT_CHARS_MAX = 20;
+constexpr size_t DOUBLE_CHARS_MAX = 32;
+
+// Writes `value` in decimal to `buf` and returns the end of the written
+// characters. Nothing is allocated and no terminating NUL is written.
+char *format_int(char *buf, int64_t value);
+
+// Writes the shortest decimal representation of `value` that reads back as
+// the same double, e.g. "0.1", "2.0", "1e+100".
+char *format_double(char *buf, double value);
+
+// Parses an optionally signed decimal integer at the beginning of
+// [first, last). Returns the end of the parsed characters, or `first` when
+// there is no integer or it does not fit in int64_t.
+const char *parse_int(const char *first, const char *last, int64_t &out);
+
+// Parses a decimal floating point number ("12", "-3.25", "1e9") at the
+// beginning of [first, last). Returns the end of the parsed characters, or
+// `first` when there is no number.
+const char *parse_double(const char *first, const char *last, double &out);
+} // namespace holang
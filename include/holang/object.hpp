@@ -4,16 +4,19 @@
 #include <iostream>
 #include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace holang {
+class OutputBuffer;
 class Klass;
+class Cell;
 struct Func;
 struct Value;
 
 class Object {
 public:
-  Klass *klass;
+  Klass *klass = nullptr;
   std::map<std::string, Func *> methods;
   std::map<std::string, Object *> fields;
 
@@ -27,6 +30,7 @@ public:
     fields.emplace(name, obj);
   }
   virtual const std::string to_s() { return "<Object>"; }
+  virtual void write_to(OutputBuffer &out);
 };
 
 class Klass : public Object {
@@ -35,9 +39,25 @@ class Klass : public Object {
 public:
   Klass(std::string name) : name(name) { init(); }
   Klass(const char name[]) : name(name) { init(); }
-  static Klass Int;
-  static Klass String;
+  // builtin classes of the isolate entered by the current thread
+  static thread_local Klass *Int;
+  static thread_local Klass *Double;
+  static thread_local Klass *BigInt;
+  static thread_local Klass *String;
+  static thread_local Klass *Array;
+  static thread_local Klass *Hash;
+  static thread_local Klass *StringBuilder;
+  static thread_local Klass *Range;
+  static thread_local Klass *Lazy;
+  static thread_local Klass *File;
+  static thread_local Klass *FileWriter;
+  static thread_local Klass *Future;
+  static thread_local Klass *Coroutine;
+  static thread_local Klass *IO;
+  static thread_local Klass *Stream;
+  static thread_local Klass *Channel;
   virtual const std::string to_s() { return "<" + name + ">"; }
+  const std::string &get_name() const { return name; }
 
   Object *new_object() {
     auto *obj = new Object();
@@ -52,17 +72,41 @@ enum FuncType {
   FUSERDEF,
 };
 
-using NativeFunc = std::function<Value(Value *, Value *, int)>;
+// a builtin: called with the receiver and the arguments, see bind.hpp
+using NativeFunc = Value (*)(Value *self, Value *args, int argc);
 
 struct Func {
   FuncType type;
   NativeFunc native;
   CodeSequence body;
+  // slots for self, parameters and local variables of a user defined func
+  int local_size = 0;
+  // a call returns a Coroutine running the body
+  bool generator = false;
+  // A block using variables of the frames around it: pairs of the slot
+  // holding the Cell of one in the frame evaluating the block, and the slot
+  // of the block's frame which receives it.
+  std::vector<std::pair<int, int>> captures;
+  // A closure, made by MAKE_CLOSURE: the block it runs and the cells it
+  // took for the block's captures.
+  const Func *block = nullptr;
+  std::vector<Cell *> cells;
 
   // Func() {}
   Func(const Func &func)
-      : type(func.type), native(func.native), body(func.body) {}
+      : type(func.type), native(func.native), body(func.body),
+        local_size(func.local_size), generator(func.generator),
+        captures(func.captures), block(func.block), cells(func.cells) {}
   Func(NativeFunc native) : type(FBUILTIN), native(native) {}
-  Func(const CodeSequence &body) : type(FUSERDEF), body(body) {}
+  Func(CodeSequence body, int local_size = 0)
+      : type(FUSERDEF), body(std::move(body)), local_size(local_size) {}
+  Func(const Func *block, std::vector<Cell *> cells)
+      : type(FUSERDEF), local_size(block->local_size), block(block),
+        cells(std::move(cells)) {}
+
+  // the code a call runs, which a closure shares with its block
+  const CodeSequence &code() const {
+    return block != nullptr ? block->body : body;
+  }
 };
 } // namespace holang
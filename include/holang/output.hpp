@@ -0,0 +1,77 @@
+#pragma once
+
+#include "holang/number.hpp"
+#include "holang/value.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace holang {
+/*
+ * Buffered writer over a file descriptor.
+ *
+ * Values are formatted straight into the buffer. The buffer is written out
+ * when it is full, on flush() and on destruction. When the descriptor is a
+ * TTY it is also written out at the end of every line.
+ */
+class OutputBuffer {
+public:
+  OutputBuffer(int fd, size_t capacity = 1 << 16);
+  ~OutputBuffer();
+  OutputBuffer(const OutputBuffer &) = delete;
+  OutputBuffer &operator=(const OutputBuffer &) = delete;
+
+  void write(const char *data, size_t size) {
+    if (size <= capacity - pos) {
+      std::memcpy(buf + pos, data, size);
+      pos += size;
+    } else {
+      write_slow(data, size);
+    }
+  }
+  void write(const std::string &str) { write(str.data(), str.size()); }
+  void write(char c) {
+    if (pos == capacity) {
+      flush();
+    }
+    buf[pos++] = c;
+  }
+  void write(int64_t i) {
+    if (capacity - pos < INT_CHARS_MAX) {
+      flush();
+    }
+    pos = format_int(buf + pos, i) - buf;
+  }
+  void write(double d) {
+    if (capacity - pos < DOUBLE_CHARS_MAX) {
+      flush();
+    }
+    pos = format_double(buf + pos, d) - buf;
+  }
+  void write(Value &val);
+
+  void end_line() {
+    write('\n');
+    if (line_buffered) {
+      flush();
+    }
+  }
+  void flush();
+
+  bool is_line_buffered() const { return line_buffered; }
+
+private:
+  void write_slow(const char *data, size_t size);
+  void write_fd(const char *data, size_t size);
+
+  const int fd;
+  char *buf;
+  size_t pos = 0;
+  const size_t capacity;
+  bool line_buffered;
+};
+
+// buffer of the standard output of the current isolate, flushed at exit
+OutputBuffer &standard_output();
+} // namespace holang
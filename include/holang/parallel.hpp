@@ -0,0 +1,27 @@
+#pragma once
+
+#include "holang/object.hpp"
+
+namespace holang {
+/*
+ * Data-parallel loops over integers: n.parallel_times { |i| },
+ * n.parallel_map { |i| } and (a..b).parallel_map { |i| }.
+ *
+ * The indices are split into chunks which run on the spawn { } workers and
+ * the calling thread; parallel_map collects the results in index order.
+ * A block runs in parallel only if is_safe() proves it pure, otherwise
+ * (and with a single worker) the loop runs serially on the caller.
+ */
+class Parallel {
+public:
+  // Whether `func` may run on several threads at once. Its code, and the
+  // code of the blocks and user defined methods it may call, must only use
+  // locals, literals and the objects it creates: no method which mutates
+  // its receiver or prints, no definitions, imports, index stores or
+  // yields. A call is resolved by name against every class, so a method
+  // defined by any class under that name must be safe too.
+  static bool is_safe(Func *func);
+
+  static void init();
+};
+} // namespace holang
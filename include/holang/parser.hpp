@@ -44,6 +44,7 @@ private:
 
 private:
   Node *read_toplevel();
+  Node *with_cells(Node *body);
 
   Node *read_stmt();
   Node *read_if();
@@ -51,6 +52,7 @@ private:
   Node *read_klassdef();
   Node *read_import();
   Node *read_while();
+  Node *read_for();
   Node *read_return();
   Node *read_suite();
 
@@ -58,6 +60,7 @@ private:
   Node *read_assignment_expr();
   Node *read_equal_expr();
   Node *read_comp_expr();
+  Node *read_range_expr();
   Node *read_multiplicative_expr();
   Node *read_additive_expr();
   Node *read_factor();
@@ -67,8 +70,13 @@ private:
   Node *read_prime();
   Node *read_number();
   Node *read_string();
+  Node *read_interpolation();
+  Node *read_array();
+  Node *read_yield();
   Node *read_name_or_funccall(bool is_trailer);
   Node *read_block();
+  Node *loop_call(const std::string &name, const std::vector<Node *> &args,
+                  LambdaNode *block);
   void read_exprs(std::vector<Node *> &args);
   void read_arglist(std::vector<Node *> *args);
   void read_params(std::vector<std::string *> *params);
@@ -95,5 +103,9 @@ private:
   const std::vector<Token *> token_chain;
   VariableTable variable_table;
   int head = 0;
+  int yield_count = 0; // `yield`s read so far outside of blocks
+  // whether self is the main object where the parser is: at the top level
+  // and in blocks, but not in funcs or class bodies
+  bool self_is_main = true;
 };
 } // namespace holang
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "holang/object.hpp"
+#include "holang/value.hpp"
+#include <cstdint>
+
+namespace holang {
+// Integers from first to last, both inclusive.
+class Range : public Object {
+public:
+  Range(int64_t first, int64_t last) : first(first), last(last) {
+    klass = Klass::Range;
+  }
+
+  static bool is_range(const Value &v) {
+    return v.type == Type::OBJECT && v.objval->klass == Klass::Range;
+  }
+
+  virtual const std::string to_s();
+
+  static void init();
+
+  const int64_t first;
+  const int64_t last;
+};
+} // namespace holang
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "holang/isolate.hpp"
+#include "holang/module.hpp"
+#include "holang/object.hpp"
+#include "holang/value.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unistd.h>
+
+namespace holang {
+class HolangVM;
+
+/*
+ * Interpreter embedded in a C++ host.
+ *
+ *   Runtime runtime;
+ *   runtime.define_function("clamp", bind<&clamp>());
+ *   runtime.run(Module::load("rules.ho"));
+ *   Func *score = runtime.lookup_function("score");
+ *   Value v = runtime.call(score, 3, 4.5, "gold");
+ *
+ * A Runtime owns an isolate and one VM. Every call runs as a frame on that
+ * VM's stack and pops it again, so a call costs no allocation beyond what
+ * the function itself does. Modules are compiled once and may be run by
+ * any number of runtimes.
+ *
+ * A Runtime, and the objects it returns, belong to the thread which uses
+ * it; runtimes on different threads are independent. Errors in a script
+ * exit the process, as they do in ho.
+ */
+class Runtime {
+public:
+  Runtime(int in_fd = STDIN_FILENO, int out_fd = STDOUT_FILENO);
+  ~Runtime();
+  Runtime(const Runtime &) = delete;
+  Runtime &operator=(const Runtime &) = delete;
+
+  // Runs the top-level code of `module`, which defines its functions and
+  // classes, and returns its value.
+  Value run(const Module *module);
+
+  // Makes `native` a top-level function of the scripts, e.g. a C++
+  // function bound with bind<&fn>().
+  void define_function(const std::string &name, NativeFunc native);
+  // the top-level function `name`, or nullptr
+  Func *lookup_function(const std::string &name) const;
+
+  Value call(Func *fn, Value *args, int argc);
+  // Arguments may be Values, ints, doubles, bools or strings.
+  template <typename... Args> Value call(Func *fn, const Args &... args) {
+    Isolate::Scope scope(&isolate);
+    Value argv[] = {to_value(args)..., Value()};
+    return call(fn, argv, static_cast<int>(sizeof...(Args)));
+  }
+
+  Isolate &get_isolate() { return isolate; }
+
+private:
+  static Value to_value(const Value &v) { return v; }
+  static Value to_value(int i) { return Value(i); }
+  static Value to_value(int64_t i) { return Value(i); }
+  static Value to_value(double d) { return Value(d); }
+  static Value to_value(bool b) { return Value(b); }
+  static Value to_value(const std::string &str);
+  static Value to_value(const char *str) { return to_value(std::string(str)); }
+
+  Isolate isolate;
+  std::unique_ptr<HolangVM> vm;
+};
+} // namespace holang
@@ -0,0 +1,212 @@
+#pragma once
+
+#include "holang/object.hpp"
+#include "holang/value.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace holang {
+class HolangVM;
+class Isolate;
+
+// Result of a task started by spawn { }. await(future) returns its value.
+class Future : public Object {
+public:
+  Future() { klass = Klass::Future; }
+
+  static bool is_future(const Value &v) {
+    return v.type == Type::OBJECT && v.objval->klass == Klass::Future;
+  }
+
+  bool is_done() const { return done.load(std::memory_order_acquire); }
+  // only valid once is_done()
+  Value get() const { return value; }
+  void resolve(Value v);
+  // blocks until resolved or `timeout` passes
+  void wait_for(std::chrono::microseconds timeout);
+
+  virtual const std::string to_s() { return "<Future>"; }
+
+  static void init();
+
+private:
+  Value value;
+  std::atomic<bool> done{false};
+  std::mutex mutex;
+  std::condition_variable resolved;
+};
+
+/*
+ * Chase-Lev work-stealing deque (Le et al., "Correct and Efficient
+ * Work-Stealing for Weak Memory Models", PPoPP 2013).
+ *
+ * The owner pushes and pops at the bottom; other threads steal from the
+ * top. The ring grows when it is full; old rings are kept until the deque
+ * is destroyed because a thief may still be reading one.
+ */
+template <typename T> class WorkStealingDeque {
+public:
+  explicit WorkStealingDeque(int64_t capacity = 64)
+      : ring(new Ring(capacity)) {
+    rings.emplace_back(ring.load(std::memory_order_relaxed));
+  }
+  WorkStealingDeque(const WorkStealingDeque &) = delete;
+  WorkStealingDeque &operator=(const WorkStealingDeque &) = delete;
+
+  // owner only
+  void push(T *item) {
+    int64_t b = bottom.load(std::memory_order_relaxed);
+    int64_t t = top.load(std::memory_order_acquire);
+    Ring *r = ring.load(std::memory_order_relaxed);
+    if (b - t >= r->capacity) {
+      r = grow(r, t, b);
+    }
+    r->put(b, item);
+    bottom.store(b + 1, std::memory_order_release);
+  }
+
+  // owner only; nullptr when empty
+  T *pop() {
+    int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+    Ring *r = ring.load(std::memory_order_relaxed);
+    bottom.store(b, std::memory_order_seq_cst);
+    int64_t t = top.load(std::memory_order_seq_cst);
+    if (t > b) {
+      bottom.store(b + 1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    T *item = r->get(b);
+    if (t == b) {
+      // the last item: race against thieves for it
+      if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                       std::memory_order_relaxed)) {
+        item = nullptr;
+      }
+      bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return item;
+  }
+
+  // any thread; nullptr when empty or another thread won the item
+  T *steal() {
+    int64_t t = top.load(std::memory_order_seq_cst);
+    int64_t b = bottom.load(std::memory_order_seq_cst);
+    if (t >= b) {
+      return nullptr;
+    }
+    Ring *r = ring.load(std::memory_order_acquire);
+    T *item = r->get(t);
+    if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                     std::memory_order_relaxed)) {
+      return nullptr;
+    }
+    return item;
+  }
+
+  bool empty() const {
+    return top.load(std::memory_order_relaxed) >=
+           bottom.load(std::memory_order_relaxed);
+  }
+
+private:
+  struct Ring {
+    explicit Ring(int64_t capacity)
+        : capacity(capacity), slots(new std::atomic<T *>[capacity]) {}
+    T *get(int64_t i) const {
+      return slots[i & (capacity - 1)].load(std::memory_order_relaxed);
+    }
+    void put(int64_t i, T *item) {
+      slots[i & (capacity - 1)].store(item, std::memory_order_relaxed);
+    }
+    const int64_t capacity; // power of two
+    std::unique_ptr<std::atomic<T *>[]> slots;
+  };
+
+  Ring *grow(Ring *old, int64_t t, int64_t b) {
+    Ring *grown = new Ring(old->capacity * 2);
+    for (int64_t i = t; i < b; i++) {
+      grown->put(i, old->get(i));
+    }
+    rings.emplace_back(grown);
+    ring.store(grown, std::memory_order_release);
+    return grown;
+  }
+
+  std::atomic<int64_t> top{0};
+  std::atomic<int64_t> bottom{0};
+  std::atomic<Ring *> ring;
+  // every ring ever used, owned by the deque
+  std::vector<std::unique_ptr<Ring>> rings;
+};
+
+/*
+ * Runs the tasks of spawn { } on worker threads, one per CPU.
+ *
+ * Each worker has a deque of tasks and a VM of its own. A task spawned by
+ * a task goes to the bottom of its worker's deque; tasks spawned from other
+ * threads go to a shared queue. An idle worker takes from its own deque,
+ * then the shared queue, then steals from the top of the other workers'
+ * deques. await() runs queued tasks while it waits, so a task may await
+ * the tasks it spawned without blocking its worker.
+ *
+ * Tasks share the objects of their isolate. Mutating an object from two
+ * tasks at once, or defining functions and reopening classes inside a
+ * task, is not synchronized.
+ */
+class Scheduler {
+public:
+  Scheduler(Isolate *isolate, unsigned worker_count);
+  // runs the tasks still queued, then joins the workers
+  ~Scheduler();
+  Scheduler(const Scheduler &) = delete;
+  Scheduler &operator=(const Scheduler &) = delete;
+
+  Future *spawn(Func *func, std::vector<Value> &&args);
+  // Runs `body` on a worker with the worker's VM; the future gets its value.
+  Future *submit(std::function<Value(HolangVM *)> &&body);
+  Value await(Future *future);
+
+  unsigned get_worker_count() const { return workers.size(); }
+
+private:
+  struct Task {
+    std::function<Value(HolangVM *)> body;
+    Future *future;
+  };
+  struct Worker {
+    Scheduler *scheduler;
+    unsigned index;
+    WorkStealingDeque<Task> deque{};
+    std::thread thread{};
+  };
+
+  void work(Worker *worker);
+  Task *find_task(Worker *self);
+  void run(Task *task, HolangVM *vm);
+  void wake_one();
+
+  static thread_local Worker *current_worker;
+
+  Isolate *const isolate;
+  std::vector<std::unique_ptr<Worker>> workers;
+
+  // tasks spawned by threads which are not workers
+  std::mutex shared_mutex;
+  std::deque<Task *> shared_queue;
+
+  // tasks pushed and not taken yet, for the sleeping workers
+  std::atomic<int64_t> queued{0};
+  std::atomic<int> sleepers{0};
+  std::mutex sleep_mutex;
+  std::condition_variable wake;
+  bool stopping = false;
+};
+} // namespace holang
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "config.hpp"
+#include "holang/instruction.hpp"
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace holang {
+struct Value;
+
+/*
+ * Execution counters for `ho --stats`.
+ *
+ * The counters are only compiled in when HOLANG_ENABLE_STATS is defined, and
+ * even then the VM only touches them while `Stats::enabled` is set. Each
+ * thread counts into its own counters, which the report adds up.
+ */
+class Stats {
+public:
+  static void enable(const std::string &json_path = "");
+
+  static void count_instruction(Instruction op) {
+    Counters &c = counters();
+    size_t index = static_cast<size_t>(op);
+    bump(c.instructions[index]);
+    bump(c.pairs[c.prev_instruction][index]);
+    c.prev_instruction = index;
+  }
+
+  static void count_call(const Value &self, const std::string *method_name);
+
+  static void report(std::ostream &out);
+  static void dump_json(std::ostream &out);
+
+  static std::atomic<bool> enabled;
+
+private:
+  // The counters of one thread. Only that thread writes them, so a counter
+  // is bumped by a relaxed load and store rather than a locked add.
+  struct Counters {
+    std::atomic<uint64_t> instructions[INSTRUCTION_SIZE] = {};
+    // The extra row counts the first instruction executed by the thread.
+    std::atomic<uint64_t> pairs[INSTRUCTION_SIZE + 1][INSTRUCTION_SIZE] = {};
+    size_t prev_instruction = INSTRUCTION_SIZE;
+    std::mutex mutex; // guards `calls` against the report
+    // receiver class name -> method name -> count. The names are copied:
+    // classes are gone by the time the report is written at exit.
+    std::map<std::string, std::map<std::string, uint64_t>> calls;
+  };
+
+  static void bump(std::atomic<uint64_t> &counter) {
+    counter.store(counter.load(std::memory_order_relaxed) + 1,
+                  std::memory_order_relaxed);
+  }
+  static Counters &counters() {
+    return local != nullptr ? *local : add_counters();
+  }
+  static Counters &add_counters();
+  // the counters of every thread added up
+  struct Totals;
+  static void add_up(Totals &totals);
+  static void report_at_exit();
+
+  static thread_local Counters *local;
+  // The counters of every thread which counted. They are never freed:
+  // threads still running while the program exits may count into them.
+  static std::mutex all_mutex;
+  static std::vector<Counters *> *all;
+  static std::string json_path;
+};
+} // namespace holang
@@ -1,15 +1,135 @@
 #pragma once
 
 #include "holang/object.hpp"
+#include "holang/value.hpp"
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
 
 namespace holang {
+/*
+ * Immutable string.
+ *
+ * Strings up to INLINE_CAPACITY bytes are stored inside the object, so a
+ * short string costs one allocation. Longer ones point into a refcounted
+ * heap buffer, which slices of them (slice, split, strip, ...) share
+ * instead of copying. A long string made by concat() leaves room after its
+ * characters, so that `s = s + piece` appends in place rather than copying
+ * s again.
+ */
 class String : public Object {
 public:
-  String(const std::string &str) : str(str) { klass = &Klass::String; }
-  virtual const std::string to_s() { return str; }
+  static constexpr size_t INLINE_CAPACITY = 24;
+
+  String(const std::string &str) : String(str.data(), str.size()) {}
+  String(const char *data, size_t size) : String(size) {
+    std::memcpy(mutable_data(), data, size);
+  }
+  String(const String &) = delete;
+  String &operator=(const String &) = delete;
+
+  static bool is_string(const Value &v) {
+    return v.type == Type::OBJECT && v.objval->klass == Klass::String;
+  }
+
+  const char *data() const { return chars; }
+  size_t size() const { return length; }
+
+  // [offset, offset + size) of this string; shares the buffer unless the
+  // slice is short enough to be inlined
+  String *slice(size_t offset, size_t size);
+  // [chars, chars + size) of a buffer owned by `buffer`
+  static String *view(const std::shared_ptr<const char> &buffer,
+                      const char *chars, size_t size);
+  // the heap buffer holding the characters; nullptr when they are inline
+  const std::shared_ptr<const char> &get_buffer() const { return buffer; }
+  std::string str() const { return std::string(data(), length); }
+  int compare(const String &other) const;
+  bool equals(const String &other) const {
+    return length == other.length &&
+           std::memcmp(data(), other.data(), length) == 0;
+  }
+
+  virtual const std::string to_s() { return str(); }
+  virtual void write_to(OutputBuffer &out);
+
+  // computed on first use and cached; strings are immutable
+  uint64_t hash() {
+    if (!hashed) {
+      hash_value = hash_bytes(data(), length);
+      hashed = true;
+    }
+    return hash_value;
+  }
+  static uint64_t hash_bytes(const char *data, size_t size);
+
+  // lhs followed by rhs. When lhs was made by concat() and nothing was
+  // appended to it yet, rhs is written into the room after it and the
+  // result shares its buffer; otherwise both are copied into a new buffer
+  // with room for as much again.
+  static String *concat(const String &lhs, const String &rhs);
+
+  static void init();
+
+private:
+  // uninitialized contents of `size` bytes
+  explicit String(size_t size) : length(size) {
+    klass = Klass::String;
+    if (size <= INLINE_CAPACITY) {
+      chars = inline_chars;
+    } else {
+      buffer.reset(new char[size], std::default_delete<char[]>());
+      chars = buffer.get();
+    }
+  }
+  String(const std::shared_ptr<const char> &buffer, const char *chars,
+         size_t size)
+      : length(size), chars(chars), buffer(buffer) {
+    klass = Klass::String;
+  }
+  char *mutable_data() { return const_cast<char *>(chars); }
+
+  size_t length;
+  const char *chars; // inline_chars or a range of buffer
+  std::shared_ptr<const char> buffer;
+  char inline_chars[INLINE_CAPACITY];
+  uint64_t hash_value = 0;
+  bool hashed = false;
+  // buffer has the room of concat() before it (see string.cpp)
+  bool appendable = false;
+};
+
+/*
+ * Growable buffer for building a String piece by piece.
+ *
+ * Numbers are formatted straight into the buffer and the buffer grows
+ * geometrically, so appending n pieces costs O(total length). Scripts use it
+ * as StringBuilder.new(); the VM uses one for interpolation.
+ */
+class StringBuilder : public Object {
+public:
+  StringBuilder() { klass = Klass::StringBuilder; }
+
+  static bool is_string_builder(const Value &v) {
+    return v.type == Type::OBJECT && v.objval->klass == Klass::StringBuilder;
+  }
+
+  void append(const char *data, size_t size) { buf.append(data, size); }
+  void append(const String &str) { append(str.data(), str.size()); }
+  // Strings as they are, numbers formatted, anything else by to_s()
+  void append(const Value &v);
+  void clear() { buf.clear(); }
+  size_t size() const { return buf.size(); }
+
+  String *build() const { return new String(buf.data(), buf.size()); }
+
+  virtual const std::string to_s() { return buf; }
+  virtual void write_to(OutputBuffer &out);
 
   static void init();
 
-  const std::string str;
+private:
+  std::string buf;
 };
 } // namespace holang
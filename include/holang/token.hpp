@@ -8,6 +8,9 @@ enum class TokenType {
   Integer,
   Double,
   String,
+  StringBegin, // "...#{
+  StringMid,   // }...#{
+  StringEnd,   // }..."
   Ident,
   True,
   False,
@@ -43,6 +46,9 @@ enum class TokenType {
   Import,
   While,
   Return,
+  For,
+  In,
+  Yield,
 
   // delimiter
   ParenL,     // (
@@ -53,6 +59,7 @@ enum class TokenType {
   BracketR,   // ]
   Comma,      // ,
   Dot,        // .
+  DotDot,     // ..
   VertialBar, // |
   Anpersand,  // &
   NewLine,    // \n
@@ -75,10 +82,16 @@ struct Token {
   Token(TokenType type, const std::string &str) : type(type), str(str) {}
 
   ~Token() {
-    if (type == TokenType::String || type == TokenType::Ident) {
+    if (has_str()) {
       str.~basic_string();
     }
   }
+
+  bool has_str() const {
+    return type == TokenType::String || type == TokenType::StringBegin ||
+           type == TokenType::StringMid || type == TokenType::StringEnd ||
+           type == TokenType::Ident;
+  }
 };
 
 static std::ostream &operator<<(std::ostream &out, const TokenType type) {
@@ -90,6 +103,12 @@ static std::ostream &operator<<(std::ostream &out, const TokenType type) {
     return out << "Double";
   case TokenType::String:
     return out << "String";
+  case TokenType::StringBegin:
+    return out << "StringBegin";
+  case TokenType::StringMid:
+    return out << "StringMid";
+  case TokenType::StringEnd:
+    return out << "StringEnd";
   case TokenType::Ident:
     return out << "Ident";
   case TokenType::True:
@@ -156,6 +175,12 @@ static std::ostream &operator<<(std::ostream &out, const TokenType type) {
     return out << "While";
   case TokenType::Return:
     return out << "return";
+  case TokenType::For:
+    return out << "For";
+  case TokenType::Yield:
+    return out << "Yield";
+  case TokenType::In:
+    return out << "In";
 
   // delimitor
   case TokenType::ParenL:
@@ -174,6 +199,8 @@ static std::ostream &operator<<(std::ostream &out, const TokenType type) {
     return out << "Comma";
   case TokenType::Dot:
     return out << "Dot";
+  case TokenType::DotDot:
+    return out << "DotDot";
   case TokenType::VertialBar:
     return out << "VertialBar";
   case TokenType::Anpersand:
@@ -194,8 +221,7 @@ static std::ostream &operator<<(std::ostream &out, const Token *token) {
     return out << token->type << " " << token->i;
   } else if (token->type == TokenType::Double) {
     return out << token->type << " " << token->d;
-  } else if (token->type == TokenType::Ident ||
-             token->type == TokenType::String) {
+  } else if (token->has_str()) {
     return out << token->type << " " << token->str;
   } else {
     return out << token->type;
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace holang {
+/*
+ * Chrome trace-event recorder for `ho --trace=FILE`.
+ *
+ * Events are buffered in memory and written as a JSON array at exit, so the
+ * file can be opened with chrome://tracing or https://ui.perfetto.dev.
+ * Each thread records into a buffer of its own, tagged with its thread id;
+ * the buffers are merged when the file is written.
+ */
+class Trace {
+public:
+  static void enable(const std::string &path);
+
+  // duration events; every begin() has to be closed by an end()
+  static void begin(const std::string &name, const char *category);
+  static void end();
+
+  // scoped complete ("X") event
+  class Scope {
+  public:
+    Scope(const std::string &name, const char *category)
+        : name(enabled ? name : std::string()), category(category),
+          start(enabled ? now() : 0) {}
+    ~Scope() {
+      if (enabled) {
+        complete(name, category, start);
+      }
+    }
+
+  private:
+    const std::string name;
+    const char *category;
+    const double start;
+  };
+
+  static std::atomic<bool> enabled;
+
+private:
+  struct Event {
+    char phase;
+    std::string name;
+    const char *category;
+    double ts;
+    double dur;
+  };
+
+  // the events of one thread, which only that thread adds to
+  struct Buffer {
+    int tid;
+    std::mutex mutex; // against write_at_exit() while the thread runs
+    std::vector<Event> events;
+  };
+
+  static Buffer &buffer();
+  static void add(const Event &event);
+  static double now();
+  static void complete(const std::string &name, const char *category,
+                       double start);
+  static void write_at_exit();
+
+  static thread_local Buffer *local;
+  // The buffers of every thread which recorded an event. They are never
+  // freed: threads still running while the program exits may add to them.
+  static std::mutex buffers_mutex;
+  static std::vector<Buffer *> *buffers;
+  static std::string path;
+};
+} // namespace holang
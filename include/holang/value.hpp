@@ -1,6 +1,8 @@
 #pragma once
 
+#include "holang/number.hpp"
 #include "holang/object.hpp"
+#include <cstdint>
 #include <string>
 
 namespace holang {
@@ -17,7 +19,7 @@ struct Func;
 struct Value {
   Type type;
   union {
-    int ival;
+    int64_t ival;
     double dval;
     bool bval;
     Func *funcval;
@@ -26,6 +28,7 @@ struct Value {
 
   Value() {}
   Value(int i) : type(Type::INT), ival(i) {}
+  Value(int64_t i) : type(Type::INT), ival(i) {}
   Value(double d) : type(Type::DOUBLE), dval(d) {}
   Value(bool b) : type(Type::BOOL), bval(b) {}
   Value(Func *func) : type(Type::FUNCTION), funcval(func) {}
@@ -35,13 +38,14 @@ struct Value {
   Object *find_field(const std::string &name);
 
   const std::string to_s() {
+    char buf[DOUBLE_CHARS_MAX];
     switch (type) {
     case Type::INT:
-      return std::to_string(ival);
+      return std::string(buf, format_int(buf, ival));
     case Type::BOOL:
       return bval ? "true" : "false";
     case Type::DOUBLE:
-      return std::to_string(dval);
+      return std::string(buf, format_double(buf, dval));
     case Type::FUNCTION:
       return "Func";
     case Type::OBJECT:
@@ -1,41 +1,55 @@
 #pragma once
 
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace holang {
 class VariableTable {
+public:
+  // A named slot of a frame. Nodes refer to it after its table is gone, as
+  // whether blocks use it is only known at the end of its frame.
+  struct Variable {
+    std::string name;
+    int index;
+    // blocks use it, so its slot holds a Cell
+    bool captured = false;
+  };
+
 private:
   class Table {
   public:
-    Table(Table *prev) : vec({"self"}), prev(prev) {}
-    std::pair<int, int> find(const std::string &ident, int depth = 0) const {
-      auto iter = std::find(vec.begin(), vec.end(), ident);
-      if (iter == vec.end()) {
-        if (prev == nullptr) {
-          return make_pair(-1, -1);
-        } else {
-          return prev->find(ident, depth + 1);
+    Table(Table *prev, bool block) : prev(prev), block(block) {
+      insert("self");
+    }
+    Variable *find(const std::string &ident) const {
+      for (Variable *var : vars) {
+        if (var->name == ident) {
+          return var;
         }
-      } else {
-        int pos = distance(vec.begin(), iter);
-        return make_pair(depth, pos);
       }
+      return nullptr;
     }
-    int insert(const std::string &ident) {
-      vec.push_back(ident);
-      return vec.size() - 1;
+    Variable *insert(const std::string &ident) {
+      vars.push_back(new Variable{ident, (int)vars.size()});
+      return vars.back();
     }
     Table *get_prev() { return prev; }
-    int size() { return vec.size(); }
+    bool is_block() const { return block; }
+    int size() { return vars.size(); }
+
+    std::vector<Variable *> vars;
+    // slots of the frame around a block and of the block's frame, see
+    // Func::captures
+    std::vector<std::pair<int, int>> captures;
 
   private:
-    std::vector<const std::string> vec;
     Table *prev;
+    bool block;
   };
 
 public:
-  VariableTable() : current(new Table(nullptr)) {}
+  VariableTable() : current(new Table(nullptr, false)) {}
   ~VariableTable() {
     while (current != nullptr) {
       Table *trash = current;
@@ -43,28 +57,78 @@ public:
       delete trash;
     }
   }
-  std::pair<int, int> find(const std::string &ident) const {
-    return current->find(ident);
-  }
-  void insert(const std::string &ident) { current->insert(ident); }
-  std::pair<int, int> insert_if_absent(const std::string &ident) {
-    auto res = find(ident);
-    if (res.first >= 0) {
-      return res;
-    } else {
-      int pos = current->insert(ident);
-      return make_pair(0, pos);
+  // The variable `ident` of the current frame, or nullptr. A block also
+  // sees the variables of the blocks around it and of the func or top level
+  // they are in, but not of other funcs. Such a variable is captured: it
+  // gets a slot in each block from there to here, and `depth` is the number
+  // of them.
+  Variable *find(const std::string &ident, int *depth = nullptr) {
+    int d = 0;
+    Variable *var = find(current, ident, d);
+    if (depth != nullptr) {
+      *depth = d;
     }
+    return var;
+  }
+  Variable *insert(const std::string &ident) { return current->insert(ident); }
+  // a slot of the current frame which has no name
+  int insert_hidden() { return current->insert("")->index; }
+  Variable *insert_if_absent(const std::string &ident, int *depth = nullptr) {
+    Variable *var = find(ident, depth);
+    return var != nullptr ? var : insert(ident);
   }
-  void next() { current = new Table(current); }
+  // the frame of a func or of a block
+  void next() { current = new Table(current, false); }
+  void next_block() { current = new Table(current, true); }
   void prev() {
     Table *trash = current;
     current = current->get_prev();
     delete trash;
   }
   int size() { return current->size(); }
+  // what the current block captured
+  const std::vector<std::pair<int, int>> &captures() const {
+    return current->captures;
+  }
+  // Slots of the current frame whose variables blocks captured, and which
+  // get their cell in the frame itself rather than from a closure.
+  std::vector<int> cells() const {
+    std::vector<int> slots;
+    for (Variable *var : current->vars) {
+      if (var->captured && !is_capture(var->index)) {
+        slots.push_back(var->index);
+      }
+    }
+    return slots;
+  }
 
 private:
+  static Variable *find(Table *table, const std::string &ident, int &depth) {
+    Variable *var = table->find(ident);
+    if (var != nullptr || !table->is_block()) {
+      return var;
+    }
+    Variable *outer = find(table->get_prev(), ident, depth);
+    if (outer == nullptr) {
+      return nullptr;
+    }
+    depth++;
+    outer->captured = true;
+    var = table->insert(ident);
+    var->captured = true;
+    table->captures.emplace_back(outer->index, var->index);
+    return var;
+  }
+
+  bool is_capture(int index) const {
+    for (auto &capture : current->captures) {
+      if (capture.second == index) {
+        return true;
+      }
+    }
+    return false;
+  }
+
   Table *current;
 };
 } // namespace holang
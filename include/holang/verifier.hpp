@@ -0,0 +1,29 @@
+#pragma once
+
+#include "holang/code.hpp"
+#include <string>
+
+namespace holang {
+/*
+ * Stack effect analysis of bytecode.
+ *
+ * verify() follows every path through a CodeSequence from its first
+ * instruction and counts the values each instruction leaves on the operand
+ * stack of the frame, above self, the arguments and the locals. The count
+ * must never go below zero and must be the same on every path reaching an
+ * instruction; jumps must land on instructions. Locals, cells and the
+ * slots of loops must be within the `local_size` slots of the frame, self
+ * included. Whether a slot holds a Cell is checked when it is used.
+ * The largest count is stored as the sequence's max_stack: the VM makes room
+ * for it once when it enters a frame, so pushes do not check the size of the
+ * stack.
+ */
+class Verifier {
+public:
+  // Sets codes.max_stack, or returns false with the reason in `error`.
+  static bool verify(CodeSequence &codes, int local_size, std::string &error);
+  // verify() of `codes` and of the bodies of the funcs and blocks in it
+  static bool verify_all(CodeSequence &codes, int local_size,
+                         std::string &error);
+};
+} // namespace holang
@@ -1,14 +1,37 @@
 #pragma once
 
 #include "holang.hpp"
+#include "holang/arith.hpp"
+#include "holang/array.hpp"
+#include "holang/bignum.hpp"
+#include "holang/bind_builtins.hpp"
+#include "holang/cell.hpp"
+#include "holang/channel.hpp"
+#include "holang/coroutine.hpp"
+#include "holang/event_loop.hpp"
+#include "holang/file.hpp"
+#include "holang/hash.hpp"
+#include "holang/input.hpp"
+#include "holang/isolate.hpp"
+#include "holang/lazy.hpp"
 #include "holang/lexer.hpp"
+#include "holang/module.hpp"
+#include "holang/output.hpp"
+#include "holang/parallel.hpp"
 #include "holang/parser.hpp"
+#include "holang/range.hpp"
+#include "holang/scheduler.hpp"
+#include "holang/stats.hpp"
 #include "holang/string.hpp"
+#include "holang/trace.hpp"
+#include "holang/verifier.hpp"
 
+#include <cmath>
 #include <cstring>
 #include <fstream>
 #include <iostream>
 #include <limits>
+#include <thread>
 
 /*
 # Stack layout
@@ -23,79 +46,193 @@
 */
 
 namespace holang {
-static Value print_func(Value *, Value *args, int argc) {
-  for (int i = 0; i < argc; i++) {
-    std::cout << args[i].to_s();
+static void print_values(Args values) {
+  Isolate::OutputLock lock;
+  OutputBuffer &out = standard_output();
+  for (Value &v : values) {
+    out.write(v);
   }
-  return Value(true);
 }
 
-static Value println_func(Value *, Value *args, int argc) {
-  for (int i = 0; i < argc; i++) {
+static void println_values(Args values) {
+  Isolate::OutputLock lock;
+  OutputBuffer &out = standard_output();
+  for (int i = 0; i < values.size(); i++) {
     if (i != 0) {
-      std::cout << " ";
+      out.write(' ');
     }
-    std::cout << args[i].to_s();
+    out.write(values[i]);
   }
-  std::cout << std::endl;
-  return Value(true);
+  out.end_line();
 }
 
-static Value getline_func(Value *, Value *, int) {
-  std::string str;
-  cin >> str;
-  return Value((Object *)new String(str));
+// spawn(args...) { |params| ... } runs the block on a worker thread
+static Future *spawn_block(Args args, Func *block) {
+  return Isolate::current()->scheduler().spawn(
+      block, std::vector<Value>(args.begin(), args.end()));
 }
 
-static Value next_func(Value *self, Value *, int) {
-  return Value(self->ival + 1);
+// coroutine { |args| ... }: the block as a coroutine, started by resume
+static Coroutine *coroutine_block(Func *block) {
+  Value main_obj(Isolate::current()->main_obj);
+  return new Coroutine(block, main_obj, nullptr, 0);
 }
 
-void call_func_argc_zero(Value *self, Func *func);
-void call_func_argc_one(Value *self, Func *func, Value *arg);
+// async(args...) { |params| ... }: the block as a task of the event loop,
+// started by IO.run()
+static Coroutine *async_block(Args args, Func *block) {
+  Value main_obj(Isolate::current()->main_obj);
+  auto *task = new Coroutine(block, main_obj, args.values, args.count);
+  Isolate::current()->event_loop().start(task);
+  return task;
+}
 
-static Value times_func(Value *self, Value *args, int argc) {
-  if (argc != 1) {
-    std::cerr << "invalid argc" << std::endl;
+// sleep(ms): suspends the running task, or blocks outside of one
+static bool sleep_ms(int64_t ms) {
+  if (ms < 0) {
+    std::cerr << "sleep: milliseconds must be a non-negative Int"
+              << std::endl;
     exit(1);
   }
+  std::chrono::milliseconds duration(ms);
+  EventLoop *loop = EventLoop::suspendable();
+  if (loop != nullptr) {
+    loop->suspend_for(duration);
+    return false;
+  }
+  std::this_thread::sleep_for(duration);
+  return true;
+}
+
+// select(channels...): [index, value] of the first channel ready
+static Value select_channel(Args channels) {
+  return Channel::select(channels.values, channels.count);
+}
+
+static Value await_future(Future *future) {
+  return Isolate::current()->scheduler().await(future);
+}
+
+static void flush_output() {
+  Isolate::OutputLock lock;
+  standard_output().flush();
+}
+
+static String *read_word() {
+  Isolate::InputLock lock;
+  return standard_input().read_word();
+}
+
+// read_int: the next Int of the input, or false at its end
+static Value read_int() {
+  Isolate::InputLock lock;
+  int64_t i;
+  if (!standard_input().read_int(i)) {
+    return Value(false);
+  }
+  return Value(i);
+}
+
+static String *read_line() {
+  Isolate::InputLock lock;
+  return standard_input().read_line();
+}
+
+static bool at_eof() {
+  Isolate::InputLock lock;
+  return standard_input().eof();
+}
 
-  if (args[0].type != Type::FUNCTION) {
-    std::cerr << "have to func" << std::endl;
-    std::cerr << argc << std::endl;
-    std::cerr << args[0].to_s() << std::endl;
+static Array *read_ints(int64_t count) {
+  if (count < 0) {
+    std::cerr << "read_ints: count must be a non-negative Int" << std::endl;
     exit(1);
   }
+  Isolate::InputLock lock;
+  InputBuffer &in = standard_input();
+  std::vector<Value> ints;
+  ints.reserve(count);
+  int64_t i;
+  while ((int64_t)ints.size() < count && in.read_int(i)) {
+    ints.push_back(Value(i));
+  }
+  return new Array(std::move(ints));
+}
+
+static int64_t int_next(int64_t i) { return i + 1; }
+
+static double int_to_f(int64_t i) { return (double)i; }
+
+static int64_t double_to_i(double d) { return (int64_t)d; }
+
+static bool int_times(int64_t n, Func *block) {
+  Value self(n);
+  for (int64_t i = 0; i < n; i++) {
+    Value val(i);
+    call_func_argc_one(&self, block, &val);
+  }
+  return true;
+}
 
-  Func *func = args[0].funcval;
-  for (int i = 0; i < self->ival; i++) {
+// a.upto(b) { |i| ... } for i from a to b
+static bool int_upto(int64_t first, int64_t last, Func *block) {
+  Value self(first);
+  for (int64_t i = first; i <= last; i++) {
     Value val(i);
-    call_func_argc_one(self, func, &val);
+    call_func_argc_one(&self, block, &val);
+    if (i == last) {
+      break;
+    }
   }
-  return Value(true);
+  return true;
 }
 
 class HolangVM {
   using Codes = CodeSequence;
+  static const int NATIVE_ARGS_INLINE = 8;
 
 public:
   HolangVM(int local_val_size) {
     init_main_obj();
-    init_import_search_path();
     if (stack == nullptr)
       stack = new Value[stack_size];
-    stack_push(HolangVM::main_obj);
+    reserve_stack(1 + local_val_size);
+    stack_push(main_obj);
     sp += local_val_size;
+    main_slots = 1 + local_val_size;
   }
 
-  HolangVM(Value *args, int local_val_size) {
+  HolangVM(Value *args, int argc, int local_val_size) {
     init_main_obj();
     if (stack == nullptr)
       stack = new Value[stack_size];
-    stack_push(HolangVM::main_obj);
-    for (int i = 0; i < local_val_size; i++) {
+    reserve_stack(std::max(1 + argc, local_val_size));
+    stack_push(main_obj);
+    for (int i = 0; i < argc; i++) {
+      stack_push(args[i]);
+    }
+    reserve_locals(local_val_size);
+    main_slots = std::max(1, local_val_size);
+  }
+
+  // The VM of a coroutine: its only frame runs `func` with `self` and
+  // `args`, and starts on a small stack which grows as needed.
+  HolangVM(Func *func, Value self, Value *args, int argc)
+      : stack_size(std::max(COROUTINE_STACK_SIZE,
+                            std::max(1 + argc, func->local_size) +
+                                max_stack_of(&func->code(),
+                                             std::max(1, func->local_size)))),
+        main_slots(std::max(1, func->local_size)), coroutine(true) {
+    init_main_obj();
+    stack = new Value[stack_size];
+    stack_push(self);
+    for (int i = 0; i < argc; i++) {
       stack_push(args[i]);
     }
+    reserve_locals(func->local_size);
+    put_cells(func);
+    // code is never modified by the VM running it
+    codes = const_cast<Codes *>(&func->code());
   }
 
   ~HolangVM() {
@@ -103,116 +240,284 @@ public:
       delete[] stack;
   }
 
+  // the builtins are set up once per isolate
   void init_main_obj() {
+    isolate = Isolate::current();
+    if (isolate == nullptr) {
+      std::cerr << "HolangVM: no isolate entered" << std::endl;
+      exit(1);
+    }
+    main_obj = isolate->main_obj;
     if (main_obj != nullptr) {
       return;
     }
-    main_obj = new Object();
-    NativeFunc native = print_func;
-    main_obj->set_method("print", new Func(native));
-    NativeFunc native_println = println_func;
-    main_obj->set_method("println", new Func(native_println));
-    NativeFunc native_getline = getline_func;
-    main_obj->set_method("getline", new Func(native_getline));
-
-    NativeFunc next_native = next_func;
-    Klass::Int.set_method("next", new Func(next_native));
-    Klass::Int.set_method("times", new Func(times_func));
+    main_obj = isolate->main_obj = new Object();
+    main_obj->set_method("print", new Func(bind<&print_values>()));
+    main_obj->set_method("println", new Func(bind<&println_values>()));
+    main_obj->set_method("flush", new Func(bind<&flush_output>()));
+    main_obj->set_method("getline", new Func(bind<&read_word>()));
+    main_obj->set_method("read_int", new Func(bind<&read_int>()));
+    main_obj->set_method("read_word", new Func(bind<&read_word>()));
+    main_obj->set_method("read_line", new Func(bind<&read_line>()));
+    main_obj->set_method("eof", new Func(bind<&at_eof>()));
+    main_obj->set_method("read_ints", new Func(bind<&read_ints>()));
+    main_obj->set_method("spawn", new Func(bind<&spawn_block>()));
+    main_obj->set_method("await", new Func(bind<&await_future>()));
+    main_obj->set_method("coroutine", new Func(bind<&coroutine_block>()));
+    main_obj->set_method("async", new Func(bind<&async_block>()));
+    main_obj->set_method("sleep", new Func(bind<&sleep_ms>()));
+    main_obj->set_method("select", new Func(bind<&select_channel>()));
+
+    Klass::Int->set_method("next", new Func(bind_method<&int_next>()));
+    Klass::Int->set_method("times", new Func(bind_method<&int_times>()));
+    Klass::Int->set_method("upto", new Func(bind_method<&int_upto>()));
+    Klass::Int->set_method("to_f", new Func(bind_method<&int_to_f>()));
+    Klass::Double->set_method("to_i", new Func(bind_method<&double_to_i>()));
     String::init();
+    BigInt::init();
+    Array::init();
+    Hash::init();
+    StringBuilder::init();
+    Range::init();
+    File::init();
+    Lazy::init();
+    Future::init();
+    Coroutine::init();
+    IO::init();
+    Parallel::init();
+    Channel::init();
 
-    main_obj->set_field("Int", &Klass::Int);
-    main_obj->set_field("String", &Klass::String);
+    main_obj->set_field("Int", Klass::Int);
+    main_obj->set_field("Double", Klass::Double);
+    main_obj->set_field("String", Klass::String);
+    main_obj->set_field("Array", Klass::Array);
+    main_obj->set_field("Hash", Klass::Hash);
+    main_obj->set_field("StringBuilder", Klass::StringBuilder);
+    main_obj->set_field("Range", Klass::Range);
+    main_obj->set_field("File", Klass::File);
+    main_obj->set_field("IO", Klass::IO);
+    main_obj->set_field("Channel", Klass::Channel);
   }
 
   void eval() {
+    HolangVM *outer = running;
+    running = this;
+    reserve_stack(sp + max_stack_of(codes, main_slots));
     while (pc < codes->size()) {
-      auto op = take_code().op;
-      switch (op) {
-      case Instruction::ADD:
-        binop_add();
-        break;
-      case Instruction::SUB:
-        binop_sub();
-        break;
-      case Instruction::MUL:
-        binop_mul();
-        break;
-      case Instruction::DIV:
-        binop_div();
-        break;
-      case Instruction::MOD:
-        binop_mod();
-        break;
-      case Instruction::LESS:
-        binop_less();
-        break;
-      case Instruction::GREATER:
-        binop_greater();
-        break;
-      case Instruction::EQUAL:
-        binop_equal();
-        break;
-      case Instruction::POP:
-        sp--;
-        break;
-      case Instruction::PUT_INT:
-        put_int();
-        break;
-      case Instruction::PUT_BOOL:
-        put_bool();
-        break;
-      case Instruction::PUT_STRING:
-        put_string();
-        break;
-      case Instruction::PUT_LAMBDA:
-        put_lambda();
-        break;
-      case Instruction::LOAD_LOCAL:
-        load_local();
-        break;
-      case Instruction::STORE_LOCAL:
-        store_local();
-        break;
-      case Instruction::DEF_FUNC:
-        def_func();
-        break;
-      case Instruction::CALL_FUNC:
-        call_func();
-        break;
-      case Instruction::RET:
-        func_ret();
-        break;
-      case Instruction::PUT_SELF:
-        put_self();
-        break;
-      case Instruction::JUMP:
-        jump();
-        break;
-      case Instruction::JUMP_IF:
-        jump_if();
-        break;
-      case Instruction::JUMP_IFNOT:
-        jump_ifnot();
-        break;
-      case Instruction::LOAD_CLASS:
-        load_class();
-        break;
-      case Instruction::PREV_ENV:
-        prev_env();
-        break;
-      case Instruction::LOAD_OBJ_FIELD:
-        load_obj_field();
-        break;
-      case Instruction::IMPORT:
-        import();
-        break;
-      default:
-        std::cerr << "not implemented: " << op << std::endl;
-        exit(1);
-      }
+      execute(take_op());
+    }
+    running = outer;
+  }
+
+  // Runs a coroutine VM until its code yields or returns. `sent`, if any,
+  // becomes the value of the suspended yield expression. Returns true with
+  // the yielded value in `out`, or false with the returned value.
+  bool resume(const Value *sent, Value &out) {
+    if (sent != nullptr) {
+      stack_push(*sent);
+    }
+    HolangVM *outer = running;
+    running = this;
+    suspended = false;
+    while (!suspended && pc < codes->size()) {
+      execute(take_op());
+    }
+    running = outer;
+    out = stack_pop();
+    return suspended;
+  }
+
+  // Whether a native called by this VM's code may suspend it: only in a
+  // coroutine, and not from a block run by invoke().
+  bool can_suspend() const { return coroutine && native_depth == 0; }
+  // Suspends the coroutine when the running native returns, as if it had
+  // yielded the native's value. The value sent by the next resume becomes
+  // the value of the call instead.
+  void suspend_call() { suspended = true; }
+
+  // The VM evaluating code on this thread, if any. Natives call blocks
+  // through it so that a block runs as a frame on the caller's stack.
+  static HolangVM *current() { return running; }
+
+  // Runs `func` as a new frame on top of the stack and returns its value.
+  // The block sees the main object as self, like a block called from a
+  // fresh VM. Also usable outside eval(), e.g. by the scheduler's workers.
+  Value invoke(Func *func, Value *args, int argc) {
+    return invoke(&func->code(), func->local_size, args, argc, func);
+  }
+  // Runs `body`, which ends with RET, in a frame of `local_size` slots,
+  // which get the cells of `closure` if it is one.
+  Value invoke(const Codes *body, int local_size, Value *args, int argc,
+               const Func *closure = nullptr) {
+    HolangVM *outer = running;
+    running = this;
+    native_depth++;
+    int base = sp;
+    save_current_codes();
+    prev_ep.push_back(ep);
+    size_t depth = prev_ep.size();
+    if (Trace::enabled) {
+      Trace::begin("block", "call");
+    }
+
+    reserve_frame(base, argc, local_size, body);
+    stack_push(main_obj);
+    for (int i = 0; i < argc; i++) {
+      stack_push(args[i]);
+    }
+    // code is never modified by the VM running it
+    codes = const_cast<Codes *>(body);
+    pc = 0;
+    ep = base;
+    reserve_locals(local_size);
+    if (closure != nullptr) {
+      put_cells(closure);
+    }
+
+    // the RET of the block pops its frame
+    while (prev_ep.size() >= depth) {
+      execute(take_op());
+    }
+    Value ret = stack_pop();
+    sp = base;
+    native_depth--;
+    running = outer;
+    return ret;
+  }
+
+  __attribute__((always_inline)) void execute(Instruction op) {
+#ifdef HOLANG_ENABLE_STATS
+    if (Stats::enabled) {
+      Stats::count_instruction(op);
+    }
+#endif
+    switch (op) {
+    case Instruction::ADD:
+      binop_add();
+      break;
+    case Instruction::SUB:
+      binop_sub();
+      break;
+    case Instruction::MUL:
+      binop_mul();
+      break;
+    case Instruction::DIV:
+      binop_div();
+      break;
+    case Instruction::MOD:
+      binop_mod();
+      break;
+    case Instruction::LESS:
+      binop_less();
+      break;
+    case Instruction::GREATER:
+      binop_greater();
+      break;
+    case Instruction::EQUAL:
+      binop_equal();
+      break;
+    case Instruction::POP:
+      sp--;
+      break;
+    case Instruction::PUT_INT:
+      put_int();
+      break;
+    case Instruction::PUT_DOUBLE:
+      put_double();
+      break;
+    case Instruction::PUT_BOOL:
+      put_bool();
+      break;
+    case Instruction::PUT_STRING:
+      put_string();
+      break;
+    case Instruction::PUT_LAMBDA:
+      put_lambda();
+      break;
+    case Instruction::LOAD_LOCAL:
+      load_local();
+      break;
+    case Instruction::STORE_LOCAL:
+      store_local();
+      break;
+    case Instruction::DEF_FUNC:
+      def_func();
+      break;
+    case Instruction::CALL_FUNC:
+      call_func();
+      break;
+    case Instruction::RET:
+      func_ret();
+      break;
+    case Instruction::PUT_SELF:
+      put_self();
+      break;
+    case Instruction::JUMP:
+      jump();
+      break;
+    case Instruction::JUMP_IF:
+      jump_if();
+      break;
+    case Instruction::JUMP_IFNOT:
+      jump_ifnot();
+      break;
+    case Instruction::LOAD_CLASS:
+      load_class();
+      break;
+    case Instruction::PREV_ENV:
+      prev_env();
+      break;
+    case Instruction::LOAD_OBJ_FIELD:
+      load_obj_field();
+      break;
+    case Instruction::IMPORT:
+      import();
+      break;
+    case Instruction::NEW_ARRAY:
+      new_array();
+      break;
+    case Instruction::IDX_LOAD:
+      idx_load();
+      break;
+    case Instruction::IDX_STORE:
+      idx_store();
+      break;
+    case Instruction::CONCAT:
+      concat();
+      break;
+    case Instruction::NEW_RANGE:
+      new_range();
+      break;
+    case Instruction::LOOP_PREP:
+      loop_prep();
+      break;
+    case Instruction::LOOP_STEP:
+      loop_step();
+      break;
+    case Instruction::YIELD:
+      yield();
+      break;
+    case Instruction::MAKE_CELL:
+      make_cell();
+      break;
+    case Instruction::LOAD_CELL:
+      load_cell();
+      break;
+    case Instruction::STORE_CELL:
+      store_cell();
+      break;
+    case Instruction::MAKE_CLOSURE:
+      make_closure();
+      break;
+    default:
+      std::cerr << "not implemented: " << op << std::endl;
+      exit(1);
     }
   }
 
+  // the value returned by the evaluated code
+  Value result() { return stack[sp - 1]; }
+
   void print_stack() {
     std::cout << "--- print stack ---" << std::endl;
     printf("%2d:\t\t<- sp\n", sp);
@@ -228,213 +533,531 @@ public:
   }
 
 private:
+  // Arithmetic and comparison work on the two topmost values in place.
+  // int/int that does not overflow and double/double are handled here;
+  // anything else goes to binop_generic().
   void binop_add() {
-    auto rhs = stack_pop();
-    auto lhs = stack_pop();
-    if (lhs.type == Type::INT && rhs.type == Type::INT) {
-      stack_push(lhs.ival + rhs.ival);
-      // } else if (lhs.type == Type::INT && rhs.type == Type::DOUBLE)
-      // {
-      //   stack->push_back(Value({Type::DOUBLE, .dval = lhs.ival op
-      //   rhs.dval}));
-      // } else if (lhs.type == Type::DOUBLE && rhs.type == Type::INT)
-      // {
-      //   stack->push_back(Value({Type::DOUBLE, .dval = lhs.dval op
-      //   rhs.ival}));
-      // } else if (lhs.type == Type::DOUBLE && rhs.type ==
-      // Type::DOUBLE) {
-      //   stack->push_back(Value({Type::DOUBLE, .dval = lhs.dval op
-      //   rhs.dval}));
+    Value &lhs = stack[sp - 2];
+    const Value &rhs = stack[sp - 1];
+    int64_t r;
+    if (lhs.type == Type::INT && rhs.type == Type::INT &&
+        !__builtin_add_overflow(lhs.ival, rhs.ival, &r)) {
+      lhs.ival = r;
+    } else if (lhs.type == Type::DOUBLE && rhs.type == Type::DOUBLE) {
+      lhs.dval += rhs.dval;
     } else {
-      std::cerr << "can not cal +" << std::endl;
-      std::cerr << rhs.to_s() << std::endl;
-      std::cerr << lhs.to_s() << std::endl;
-      exit(1);
+      lhs = binop_generic(Instruction::ADD, lhs, rhs);
     }
+    sp--;
   }
   void binop_sub() {
-    auto rhs = stack_pop();
-    auto lhs = stack_pop();
-    if (lhs.type == Type::INT && rhs.type == Type::INT) {
-      stack_push(lhs.ival - rhs.ival);
-      // } else if (lhs.type == Type::INT && rhs.type == Type::DOUBLE)
-      // {
-      //   stack->push_back(Value({Type::DOUBLE, .dval = lhs.ival op
-      //   rhs.dval}));
-      // } else if (lhs.type == Type::DOUBLE && rhs.type == Type::INT)
-      // {
-      //   stack->push_back(Value({Type::DOUBLE, .dval = lhs.dval op
-      //   rhs.ival}));
-      // } else if (lhs.type == Type::DOUBLE && rhs.type ==
-      // Type::DOUBLE) {
-      //   stack->push_back(Value({Type::DOUBLE, .dval = lhs.dval op
-      //   rhs.dval}));
+    Value &lhs = stack[sp - 2];
+    const Value &rhs = stack[sp - 1];
+    int64_t r;
+    if (lhs.type == Type::INT && rhs.type == Type::INT &&
+        !__builtin_sub_overflow(lhs.ival, rhs.ival, &r)) {
+      lhs.ival = r;
+    } else if (lhs.type == Type::DOUBLE && rhs.type == Type::DOUBLE) {
+      lhs.dval -= rhs.dval;
     } else {
-      std::cerr << "can not cal -" << std::endl;
-      std::cerr << rhs.to_s() << std::endl;
-      std::cerr << lhs.to_s() << std::endl;
-      exit(1);
+      lhs = binop_generic(Instruction::SUB, lhs, rhs);
     }
+    sp--;
   }
   void binop_mul() {
-    auto rhs = stack_pop();
-    auto lhs = stack_pop();
-    if (lhs.type == Type::INT && rhs.type == Type::INT) {
-      stack_push(lhs.ival * rhs.ival);
+    Value &lhs = stack[sp - 2];
+    const Value &rhs = stack[sp - 1];
+    int64_t r;
+    if (lhs.type == Type::INT && rhs.type == Type::INT &&
+        !__builtin_mul_overflow(lhs.ival, rhs.ival, &r)) {
+      lhs.ival = r;
+    } else if (lhs.type == Type::DOUBLE && rhs.type == Type::DOUBLE) {
+      lhs.dval *= rhs.dval;
     } else {
-      std::cerr << "can not cal *" << std::endl;
-      std::cerr << rhs.to_s() << std::endl;
-      std::cerr << lhs.to_s() << std::endl;
-      exit(1);
+      lhs = binop_generic(Instruction::MUL, lhs, rhs);
     }
+    sp--;
+  }
+  // INT64_MIN / -1 overflows; a zero divisor goes to binop_generic() too,
+  // which reports it
+  static bool is_safe_divisor(const Value &lhs, const Value &rhs) {
+    return rhs.ival != 0 &&
+           !(rhs.ival == -1 && lhs.ival == std::numeric_limits<int64_t>::min());
   }
   void binop_div() {
-    auto rhs = stack_pop();
-    auto lhs = stack_pop();
-    if (lhs.type == Type::INT && rhs.type == Type::INT) {
-      stack_push(lhs.ival / rhs.ival);
+    Value &lhs = stack[sp - 2];
+    const Value &rhs = stack[sp - 1];
+    if (lhs.type == Type::INT && rhs.type == Type::INT &&
+        is_safe_divisor(lhs, rhs)) {
+      lhs.ival /= rhs.ival;
+    } else if (lhs.type == Type::DOUBLE && rhs.type == Type::DOUBLE) {
+      lhs.dval /= rhs.dval;
     } else {
-      std::cerr << "can not cal /" << std::endl;
-      std::cerr << rhs.to_s() << std::endl;
-      std::cerr << lhs.to_s() << std::endl;
-      exit(1);
+      lhs = binop_generic(Instruction::DIV, lhs, rhs);
     }
+    sp--;
   }
   void binop_mod() {
-    auto rhs = stack_pop();
-    auto lhs = stack_pop();
-    if (lhs.type == Type::INT && rhs.type == Type::INT) {
-      stack_push(lhs.ival % rhs.ival);
+    Value &lhs = stack[sp - 2];
+    const Value &rhs = stack[sp - 1];
+    if (lhs.type == Type::INT && rhs.type == Type::INT &&
+        is_safe_divisor(lhs, rhs)) {
+      lhs.ival %= rhs.ival;
     } else {
-      std::cerr << "can not cal %" << std::endl;
-      std::cerr << rhs.to_s() << std::endl;
-      std::cerr << lhs.to_s() << std::endl;
-      exit(1);
+      lhs = binop_generic(Instruction::MOD, lhs, rhs);
     }
+    sp--;
   }
   void binop_less() {
-    auto rhs = stack_pop();
-    auto lhs = stack_pop();
+    Value &lhs = stack[sp - 2];
+    const Value &rhs = stack[sp - 1];
     if (lhs.type == Type::INT && rhs.type == Type::INT) {
-      stack_push(lhs.ival < rhs.ival);
-      // } else if (lhs.type == Type::INT && rhs.type == Type::DOUBLE)
-      // {
-      //   stack->push_back(Value({Type::DOUBLE, .dval = lhs.ival op
-      //   rhs.dval}));
-      // } else if (lhs.type == Type::DOUBLE && rhs.type == Type::INT)
-      // {
-      //   stack->push_back(Value({Type::DOUBLE, .dval = lhs.dval op
-      //   rhs.ival}));
-      // } else if (lhs.type == Type::DOUBLE && rhs.type ==
-      // Type::DOUBLE) {
-      //   stack->push_back(Value({Type::DOUBLE, .dval = lhs.dval op
-      //   rhs.dval}));
+      lhs = Value(lhs.ival < rhs.ival);
+    } else if (lhs.type == Type::DOUBLE && rhs.type == Type::DOUBLE) {
+      lhs = Value(lhs.dval < rhs.dval);
     } else {
-      std::cerr << "can not cal <" << std::endl;
-      std::cerr << rhs.to_s() << std::endl;
-      std::cerr << lhs.to_s() << std::endl;
-      exit(1);
+      lhs = binop_generic(Instruction::LESS, lhs, rhs);
     }
+    sp--;
   }
 
   void binop_greater() {
-    auto rhs = stack_pop();
-    auto lhs = stack_pop();
+    Value &lhs = stack[sp - 2];
+    const Value &rhs = stack[sp - 1];
     if (lhs.type == Type::INT && rhs.type == Type::INT) {
-      stack_push(lhs.ival > rhs.ival);
+      lhs = Value(lhs.ival > rhs.ival);
+    } else if (lhs.type == Type::DOUBLE && rhs.type == Type::DOUBLE) {
+      lhs = Value(lhs.dval > rhs.dval);
     } else {
-      std::cerr << "can not cal >" << std::endl;
-      std::cerr << rhs.to_s() << std::endl;
-      std::cerr << lhs.to_s() << std::endl;
-      exit(1);
+      lhs = binop_generic(Instruction::GREATER, lhs, rhs);
     }
+    sp--;
   }
 
   void binop_equal() {
-    auto rhs = stack_pop();
-    auto lhs = stack_pop();
+    Value &lhs = stack[sp - 2];
+    const Value &rhs = stack[sp - 1];
     if (lhs.type == Type::INT && rhs.type == Type::INT) {
-      stack_push(lhs.ival == rhs.ival);
+      lhs = Value(lhs.ival == rhs.ival);
+    } else if (lhs.type == Type::DOUBLE && rhs.type == Type::DOUBLE) {
+      lhs = Value(lhs.dval == rhs.dval);
     } else {
-      std::cerr << "can not cal ==" << std::endl;
-      std::cerr << rhs.to_s() << std::endl;
-      std::cerr << lhs.to_s() << std::endl;
-      exit(1);
+      lhs = binop_generic(Instruction::EQUAL, lhs, rhs);
     }
+    sp--;
   }
 
   // put_int number
   // [] -> [val]
   void put_int() {
-    int i = take_code().ival;
+    int64_t i = take_constant().ival;
     stack_push(i);
   }
 
+  // put_double number
+  // [] -> [val]
+  void put_double() {
+    double d = take_constant().dval;
+    stack_push(d);
+  }
+
   // put_bool boolean
   // [] -> [val]
   void put_bool() {
-    bool b = take_code().bval;
+    bool b = take_int() != 0;
     stack_push(b);
   }
 
   // put_string string_ptr
   // [] -> [val]
   void put_string() {
-    std::string *str = take_code().sval;
+    std::string *str = take_constant().sval;
     stack_push(new String(*str));
   }
 
   // put_lambda lambda_ptr
   // [] -> [val]
   void put_lambda() {
-    Func *lambda = take_code().funcval;
+    Func *lambda = take_constant().funcval;
     stack_push(lambda);
   }
 
   // load_local index
   // [] -> [val]
   void load_local() {
-    int offset = take_code().ival;
+    int offset = take_int();
     stack_push(stack[ep + offset]);
   }
 
   // store_local index
   // [val] -> [val]
   void store_local() {
-    int offset = take_code().ival;
+    int offset = take_int();
     auto v = stack_top();
     stack[ep + offset] = v;
   }
 
+  // Blocks reach the variables of the frames around them through cells:
+  // the slot of a captured variable holds a Cell, as does the slot of a
+  // block's frame receiving it from the closure.
+
+  // make_cell index
+  // [] -> []: the slot gets a cell holding its value
+  void make_cell() {
+    Value &slot = stack[ep + take_int()];
+    slot = Value((Object *)new Cell(slot));
+  }
+
+  // load_cell index
+  // [] -> [val]
+  void load_cell() {
+    int index = take_int();
+    stack_push(cell_at(index)->value);
+  }
+
+  // store_cell index
+  // [val] -> [val]
+  void store_cell() {
+    int index = take_int();
+    cell_at(index)->value = stack_top();
+  }
+
+  // make_closure block_ptr
+  // [] -> [closure]: the block with the cells of its captures
+  void make_closure() {
+    const Func *block = take_constant().funcval;
+    std::vector<Cell *> cells;
+    cells.reserve(block->captures.size());
+    for (auto &capture : block->captures) {
+      cells.push_back(cell_at(capture.first));
+    }
+    stack_push(new Func(block, std::move(cells)));
+  }
+
+  Cell *cell_at(int index) {
+    const Value &v = stack[ep + index];
+    if (!Cell::is_cell(v)) {
+      std::cerr << "local " << index << " is not captured" << std::endl;
+      exit(1);
+    }
+    return (Cell *)v.objval;
+  }
+
+  // gives the frame at ep, just entered, the cells of `func` if it is a
+  // closure
+  void put_cells(const Func *func) {
+    if (func->block == nullptr) {
+      return;
+    }
+    auto &captures = func->block->captures;
+    for (size_t i = 0; i < captures.size(); i++) {
+      stack[ep + captures[i].second] = Value((Object *)func->cells[i]);
+    }
+  }
+
   // def_func func_name, func_obj
-  // [] -> [true]
+  // [] -> [true]: a func defined again replaces the one before
   void def_func() {
     auto *self = stack[ep].objval;
-    const std::string &name = *take_code().sval;
-    Func *obj = (Func *)take_code().objval;
-    self->set_method(name, obj);
+    const std::string &name = *take_constant().sval;
+    Func *obj = (Func *)take_constant().objval;
+    self->methods[name] = obj;
     stack_push(true);
   }
 
+  // new_array count
+  // [elem...] -> [array]
+  void new_array() {
+    int count = take_int();
+    std::vector<Value> elements(&stack[sp - count], &stack[sp]);
+    sp -= count;
+    stack_push(new Array(std::move(elements)));
+  }
+
+  // idx_load
+  // [recv, index] -> [val]
+  void idx_load() {
+    const Value &recv = stack[sp - 2];
+    const Value &index = stack[sp - 1];
+    if (Array::is_array(recv) && index.type == Type::INT) {
+      Value *v = ((Array *)recv.objval)->at(index.ival);
+      if (v != nullptr) {
+        stack[sp - 2] = *v;
+        sp--;
+        return;
+      }
+    } else if (Hash::is_hash(recv)) {
+      Value *v = ((Hash *)recv.objval)->find(index);
+      if (v != nullptr) {
+        stack[sp - 2] = *v;
+        sp--;
+        return;
+      }
+    }
+    static std::string name = "[]";
+    call_method(&name, 1);
+  }
+
+  // idx_store
+  // [recv, index, val] -> [val]
+  void idx_store() {
+    const Value &recv = stack[sp - 3];
+    const Value &index = stack[sp - 2];
+    if (Array::is_array(recv) && index.type == Type::INT) {
+      Value *v = ((Array *)recv.objval)->at(index.ival);
+      if (v != nullptr) {
+        *v = stack[sp - 1];
+        stack[sp - 3] = *v;
+        sp -= 2;
+        return;
+      }
+    } else if (Hash::is_hash(recv)) {
+      ((Hash *)recv.objval)->insert(index, stack[sp - 1]);
+      stack[sp - 3] = stack[sp - 1];
+      sp -= 2;
+      return;
+    }
+    static std::string name = "[]=";
+    call_method(&name, 2);
+  }
+
+  // concat count
+  // [val...] -> [str]
+  void concat() {
+    int count = take_int();
+    concat_buffer.clear();
+    for (int i = sp - count; i < sp; i++) {
+      concat_buffer.append(stack[i]);
+    }
+    sp -= count;
+    stack_push(concat_buffer.build());
+  }
+
+  // new_range
+  // [first, last] -> [range]
+  void new_range() {
+    const Value &first = stack[sp - 2];
+    const Value &last = stack[sp - 1];
+    if (first.type != Type::INT || last.type != Type::INT) {
+      exit_by_range_error(first, last);
+    }
+    Value range(new Range(first.ival, last.ival));
+    sp -= 2;
+    stack_push(range);
+  }
+
+  // Counted loops keep their state in two hidden locals: the counter (an
+  // Int) at `slot` and at `slot + 1` either the last value of the counter
+  // or the Array being iterated. `var` is the local given the current
+  // element, or -1.
+
+  // loop_prep kind, var, slot, exit_pc, fallback_pc
+  // [...] -> []
+  // Jumps to fallback_pc, leaving the stack as it is, when the operands are
+  // not Ints or, for a call of times or upto, the method is not the builtin
+  // (fallback_pc is -1 when there is no fallback).
+  void loop_prep() {
+    auto kind = static_cast<LoopKind>(take_int());
+    int var = take_int();
+    int slot = take_int();
+    int exit_pc = take_int();
+    int fallback_pc = take_int();
+    Value &counter = stack[ep + slot];
+    Value &limit = stack[ep + slot + 1];
+
+    switch (kind) {
+    case LoopKind::TIMES: {
+      const Value &n = stack[sp - 1];
+      if (n.type != Type::INT || (fallback_pc >= 0 && !builtin_loop(kind))) {
+        if (fallback_pc < 0) {
+          Value v = n;
+          std::cerr << "times: receiver must be Int: " << v.to_s() << std::endl;
+          exit(1);
+        }
+        pc = fallback_pc;
+        return;
+      }
+      counter = Value((int64_t)0);
+      limit = Value(n.ival > 0 ? n.ival - 1 : (int64_t)-1);
+      sp--;
+      break;
+    }
+    case LoopKind::BOUNDS: {
+      const Value &first = stack[sp - 2];
+      const Value &last = stack[sp - 1];
+      if (first.type != Type::INT || last.type != Type::INT ||
+          (fallback_pc >= 0 && !builtin_loop(kind))) {
+        if (fallback_pc < 0) {
+          exit_by_range_error(first, last);
+        }
+        pc = fallback_pc;
+        return;
+      }
+      counter = first;
+      limit = last;
+      sp -= 2;
+      break;
+    }
+    case LoopKind::ITERABLE: {
+      const Value &obj = stack[sp - 1];
+      if (Range::is_range(obj)) {
+        counter = Value(((Range *)obj.objval)->first);
+        limit = Value(((Range *)obj.objval)->last);
+      } else if (Array::is_array(obj) || Coroutine::is_coroutine(obj)) {
+        counter = Value((int64_t)0);
+        limit = obj;
+      } else {
+        Value v = obj;
+        std::cerr << "for: can not iterate " << v.to_s() << std::endl;
+        exit(1);
+      }
+      sp--;
+      break;
+    }
+    default:
+      std::cerr << "unknown loop kind: " << static_cast<int>(kind) << std::endl;
+      exit(1);
+    }
+
+    if (!loop_load(var, counter, limit)) {
+      pc = exit_pc;
+    }
+  }
+
+  // whether Int#times or Int#upto, which a TIMES or BOUNDS loop runs in
+  // place of, is still the builtin
+  static bool builtin_loop(LoopKind kind) {
+    static const std::string times = "times", upto = "upto";
+    bool is_times = kind == LoopKind::TIMES;
+    Func *func = Klass::Int->find_method(is_times ? times : upto);
+    return func->type == FBUILTIN &&
+           func->native == (is_times ? bind_method<&int_times>()
+                                     : bind_method<&int_upto>());
+  }
+
+  // loop_step var, slot, body_pc
+  // [] -> []
+  void loop_step() {
+    int var = take_int();
+    int slot = take_int();
+    int body_pc = take_int();
+    Value &counter = stack[ep + slot];
+    const Value &limit = stack[ep + slot + 1];
+    // compared before the increment so that a loop up to INT64_MAX ends
+    if (limit.type == Type::INT && counter.ival >= limit.ival) {
+      return;
+    }
+    counter.ival++;
+    if (loop_load(var, counter, limit)) {
+      pc = body_pc;
+    }
+  }
+
+  // Stores the current element to `var`. Returns false when the loop is over.
+  bool loop_load(int var, const Value &counter, const Value &limit) {
+    if (limit.type == Type::INT) {
+      if (counter.ival > limit.ival) {
+        return false;
+      }
+      if (var >= 0) {
+        stack[ep + var] = counter;
+      }
+      return true;
+    }
+    if (Coroutine::is_coroutine(limit)) {
+      auto *co = (Coroutine *)limit.objval;
+      Value v;
+      if (co->is_done() || !co->resume(nullptr, 0, v)) {
+        return false;
+      }
+      if (var >= 0) {
+        stack[ep + var] = v;
+      }
+      return true;
+    }
+    // the array may change its size in the loop
+    Value *element = ((Array *)limit.objval)->at(counter.ival);
+    if (element == nullptr) {
+      return false;
+    }
+    if (var >= 0) {
+      stack[ep + var] = *element;
+    }
+    return true;
+  }
+
+  // yield
+  // [val] -> [sent]: suspends the coroutine; resume() takes the value and
+  // pushes the one sent back
+  void yield() {
+    if (!coroutine) {
+      std::cerr << "yield: not in a coroutine" << std::endl;
+      exit(1);
+    }
+    if (native_depth != 0) {
+      std::cerr << "yield: can not suspend across a block called by a method"
+                << std::endl;
+      exit(1);
+    }
+    suspended = true;
+  }
+
+  void exit_by_range_error(const Value &first, const Value &last) {
+    Value f = first, l = last;
+    std::cerr << "range bounds must be Int: " << f.to_s() << ".." << l.to_s()
+              << std::endl;
+    exit(1);
+  }
+
   // call_func func_name, argc
   void call_func() {
-    std::string *func_name = take_code().sval;
-    int argc = take_code().ival;
+    std::string *func_name = take_constant().sval;
+    int argc = take_int();
+    call_method(func_name, argc);
+  }
+
+  // [self, arg...] -> [ret]
+  void call_method(std::string *func_name, int argc) {
     Value *self = &stack[sp - argc - 1];
     auto func = self->find_method(*func_name);
+#ifdef HOLANG_ENABLE_STATS
+    if (Stats::enabled) {
+      Stats::count_call(*self, func_name);
+    }
+#endif
 
     Value ret;
     if (func->type == FBUILTIN) {
-      ret = func->native(self, &stack[sp - argc], argc);
+      // The native gets copies: a block it invokes may grow and move the
+      // stack.
+      Value recv = *self;
+      Value small_args[NATIVE_ARGS_INLINE];
+      std::vector<Value> large_args;
+      Value *args = small_args;
+      if (argc > NATIVE_ARGS_INLINE) {
+        large_args.resize(argc);
+        args = large_args.data();
+      }
+      std::copy(&stack[sp - argc], &stack[sp], args);
+      ret = func->native(&recv, args, argc);
       sp = sp - argc - 1;
       stack_push(ret);
+    } else if (func->generator) {
+      auto *co = new Coroutine(func, *self, &stack[sp - argc], argc);
+      sp = sp - argc - 1;
+      stack_push(co);
     } else {
+      if (Trace::enabled) {
+        Trace::begin(*func_name, "call");
+      }
       save_current_codes();
       prev_ep.push_back(ep);
 
-      codes = &func->body;
+      codes = const_cast<Codes *>(&func->code());
       pc = 0;
       ep = sp - argc - 1;
+      reserve_frame(ep, argc, func->local_size, codes);
+      reserve_locals(func->local_size);
     }
   }
   void func_ret() {
@@ -446,32 +1069,32 @@ private:
       pc = std::numeric_limits<int>::max();
       return;
     }
+    if (Trace::enabled) {
+      Trace::end();
+    }
 
     ep = prev_ep.back();
     prev_ep.pop_back();
     load_prev_codes();
   }
   void put_self() { stack_push(stack[ep]); }
-  void jump() {
-    auto to = take_code();
-    pc = to.ival;
-  }
+  void jump() { pc = take_int(); }
   void jump_if() {
     auto cond = stack_pop();
-    auto to = take_code();
+    int to = take_int();
     if (cond.bval) {
-      pc = to.ival;
+      pc = to;
     }
   }
   void jump_ifnot() {
     auto cond = stack_pop();
-    auto to = take_code();
+    int to = take_int();
     if (!cond.bval) {
-      pc = to.ival;
+      pc = to;
     }
   }
   void load_class() {
-    const std::string *klass_name = take_code().sval;
+    const std::string *klass_name = take_constant().sval;
     auto *self = stack[ep].objval;
     auto it = self->fields.find(*klass_name);
     Klass *klass;
@@ -493,7 +1116,7 @@ private:
   }
 
   void load_obj_field() {
-    const std::string &field = *take_code().sval;
+    const std::string &field = *take_constant().sval;
     Value val = stack_pop();
     stack_push(val.find_field(field));
   }
@@ -502,63 +1125,61 @@ private:
   // [str] -> []
   void import() {
     Value target = stack_pop();
-    std::string path = target.to_s();
-    if (path.front() != '.') {
-      for (const auto &prefix : import_search_path) {
-        std::string candidate = prefix + '/' + path;
-        std::ifstream ifs(candidate);
-        if (ifs.is_open()) {
-          path = std::move(candidate);
-          break;
-        }
-      }
-    }
-    std::ifstream ifs(path);
-    if (ifs.fail()) {
-      std::cerr << path << ": Not found." << std::endl;
-      exit(1);
+    std::string path =
+        Module::resolve(target.to_s(), isolate->import_search_path);
+    const Module *module = Module::load(path);
+    if (Trace::enabled) {
+      Trace::begin("import " + path, "import");
     }
-    std::istreambuf_iterator<char> it(ifs);
-    std::istreambuf_iterator<char> last;
-    std::string source_code(it, last);
-
-    std::vector<Token *> token_chain;
-    holang::Lexer lexer(source_code);
-    lexer.lex(token_chain);
 
-    holang::Parser parser(token_chain);
-    Node *root = parser.parse();
-    CodeSequence *other_codes = new CodeSequence(path);
-    root->code_gen(other_codes);
-    other_codes->append(Instruction::RET);
+    // modules are shared and never modified by the code running them
+    auto *module_codes = const_cast<CodeSequence *>(&module->codes);
+    reserve_frame(sp, 0, module->local_size + 1, module_codes);
     auto self = stack[ep];
     stack_push(self);
 
-    for (int i = 0; i < parser.toplevel_val_size(); i++) {
+    for (int i = 0; i < module->local_size; i++) {
       stack_push(0);
     }
     prev_ep.push_back(ep);
     save_current_codes();
 
-    codes = other_codes;
+    codes = module_codes;
     pc = 0;
-    ep = sp - parser.toplevel_val_size() - 1;
+    ep = sp - module->local_size - 1;
   }
 
   void stack_push(int x) { stack_push(Value(x)); }
+  void stack_push(int64_t x) { stack_push(Value(x)); }
   void stack_push(double x) { stack_push(Value(x)); }
   void stack_push(bool x) { stack_push(Value(x)); }
   void stack_push(Object *x) { stack_push(Value(x)); }
   void stack_push(Func *x) { stack_push(Value(x)); }
-  void stack_push(const Value &val) {
-    reserve_stack();
-    stack[sp++] = val;
+  // Unchecked: entering the frame made room for every value its code
+  // pushes (see reserve_frame()).
+  void stack_push(Value val) { stack[sp++] = val; }
+
+  // makes room for the local variables of the current frame
+  void reserve_locals(int local_size) {
+    while (sp < ep + local_size) {
+      stack_push(Value());
+    }
   }
 
   Value stack_pop() { return stack[--sp]; }
   Value stack_top() { return stack[sp - 1]; }
 
-  Code take_code() { return codes->at(pc++); }
+  Instruction take_op() { return codes->op_at(pc++); }
+  int take_int() {
+    int i = codes->int_at(pc);
+    pc += CodeSequence::OPERAND_SIZE;
+    return i;
+  }
+  const Code &take_constant() {
+    const Code &code = codes->constant_at(pc);
+    pc += CodeSequence::OPERAND_SIZE;
+    return code;
+  }
   void save_current_codes() { prev_code.push_back({codes, pc}); }
   void save_ep() { prev_ep.push_back(ep); }
   void load_prev_codes() {
@@ -573,9 +1194,33 @@ private:
   }
 
 private:
-  void reserve_stack() {
-    if (sp >= stack_size) {
-      auto new_size = stack_size * 2;
+  // Makes room for a frame starting at `base` which runs `body`: slots for
+  // self, the `argc` arguments and the locals (`local_size` of them, self
+  // included), and the most values the code pushes on top of them. Values
+  // held by pointer into the stack are invalid after this, as the stack may
+  // move.
+  void reserve_frame(int base, int argc, int local_size, const Codes *body) {
+    reserve_stack(base + std::max(1 + argc, local_size) +
+                  max_stack_of(body, std::max(1, local_size)));
+  }
+
+  // verified here if the code did not come through Module, e.g. from a
+  // host compiling it by hand; its locals must be within `local_size`
+  static int max_stack_of(const Codes *body, int local_size) {
+    if (body->max_stack < 0) {
+      std::string error;
+      if (!Verifier::verify(const_cast<Codes &>(*body), local_size, error)) {
+        std::cerr << body->source_path << ": invalid code: " << error
+                  << std::endl;
+        exit(1);
+      }
+    }
+    return body->max_stack;
+  }
+
+  void reserve_stack(int size) {
+    if (size > stack_size) {
+      auto new_size = std::max(stack_size * 2, size);
       auto *new_stack = new Value[new_size];
       if (new_stack == nullptr) {
         std::cerr << "allocation error" << std::endl;
@@ -588,8 +1233,6 @@ private:
     }
   }
 
-  void init_import_search_path();
-
 public:
   Codes *codes;
 
@@ -599,9 +1242,19 @@ private:
   int sp = 0; // stack pointer
   int ep = 0; // env pointer
   int stack_size = 1024;
-  static Object *main_obj;
-  static std::vector<std::string> import_search_path;
+  static constexpr int COROUTINE_STACK_SIZE = 64;
+  // slots of the frame the VM starts with, self included
+  int main_slots = 1;
+  const bool coroutine = false;
+  bool suspended = false; // set by yield() and suspend_call()
+  // blocks being run by invoke(); a coroutine can not yield inside them
+  int native_depth = 0;
+  Isolate *isolate;
+  Object *main_obj;
+  static thread_local HolangVM *running;
   std::vector<int> prev_ep;
   std::vector<std::pair<Codes *, int>> prev_code;
+  // reused by concat() so that its buffer is allocated once
+  StringBuilder concat_buffer;
 };
 } // namespace holang
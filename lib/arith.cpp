@@ -0,0 +1,128 @@
+#include "holang/arith.hpp"
+#include "holang.hpp"
+#include "holang/bignum.hpp"
+#include "holang/string.hpp"
+#include <cmath>
+#include <iostream>
+
+using namespace std;
+using namespace holang;
+
+static double as_double(const Value &v) {
+  if (v.type == Type::INT) {
+    return v.ival;
+  } else if (v.type == Type::DOUBLE) {
+    return v.dval;
+  }
+  return BigInt::to_double(v);
+}
+
+static Value binop_double(Instruction op, double lhs, double rhs) {
+  switch (op) {
+  case Instruction::ADD:
+    return Value(lhs + rhs);
+  case Instruction::SUB:
+    return Value(lhs - rhs);
+  case Instruction::MUL:
+    return Value(lhs * rhs);
+  case Instruction::DIV:
+    return Value(lhs / rhs);
+  case Instruction::MOD:
+    return Value(fmod(lhs, rhs));
+  case Instruction::LESS:
+    return Value(lhs < rhs);
+  case Instruction::GREATER:
+    return Value(lhs > rhs);
+  case Instruction::EQUAL:
+    return Value(lhs == rhs);
+  default:
+    cerr << "binop_double: " << op << endl;
+    exit(1);
+  }
+}
+
+static Value binop_integer(Instruction op, const Value &lhs,
+                           const Value &rhs) {
+  switch (op) {
+  case Instruction::ADD:
+    return BigInt::add(lhs, rhs);
+  case Instruction::SUB:
+    return BigInt::sub(lhs, rhs);
+  case Instruction::MUL:
+    return BigInt::mul(lhs, rhs);
+  case Instruction::DIV:
+    return BigInt::div(lhs, rhs);
+  case Instruction::MOD:
+    return BigInt::mod(lhs, rhs);
+  case Instruction::LESS:
+    return Value(BigInt::compare(lhs, rhs) < 0);
+  case Instruction::GREATER:
+    return Value(BigInt::compare(lhs, rhs) > 0);
+  case Instruction::EQUAL:
+    return Value(BigInt::compare(lhs, rhs) == 0);
+  default:
+    cerr << "binop_integer: " << op << endl;
+    exit(1);
+  }
+}
+
+static Value binop_string(Instruction op, const String &lhs,
+                          const String &rhs) {
+  switch (op) {
+  case Instruction::ADD:
+    return Value((Object *)String::concat(lhs, rhs));
+  case Instruction::LESS:
+    return Value(lhs.compare(rhs) < 0);
+  case Instruction::GREATER:
+    return Value(lhs.compare(rhs) > 0);
+  case Instruction::EQUAL:
+    return Value(lhs.equals(rhs));
+  default:
+    return Value();
+  }
+}
+
+static const char *operator_name(Instruction op) {
+  switch (op) {
+  case Instruction::ADD:
+    return "+";
+  case Instruction::SUB:
+    return "-";
+  case Instruction::MUL:
+    return "*";
+  case Instruction::DIV:
+    return "/";
+  case Instruction::MOD:
+    return "%";
+  case Instruction::LESS:
+    return "<";
+  case Instruction::GREATER:
+    return ">";
+  default:
+    return "==";
+  }
+}
+
+Value holang::binop_generic(Instruction op, const Value &lhs,
+                            const Value &rhs) {
+  if (BigInt::is_integer(lhs) && BigInt::is_integer(rhs)) {
+    return binop_integer(op, lhs, rhs);
+  }
+  bool lhs_number = lhs.type == Type::DOUBLE || BigInt::is_integer(lhs);
+  bool rhs_number = rhs.type == Type::DOUBLE || BigInt::is_integer(rhs);
+  if (lhs_number && rhs_number) {
+    return binop_double(op, as_double(lhs), as_double(rhs));
+  }
+
+  if (String::is_string(lhs) && String::is_string(rhs) &&
+      op != Instruction::SUB && op != Instruction::MUL &&
+      op != Instruction::DIV && op != Instruction::MOD) {
+    return binop_string(op, *(String *)lhs.objval, *(String *)rhs.objval);
+  }
+
+  Value l = lhs, r = rhs;
+  cerr << "can not cal " << operator_name(op) << endl;
+  cerr << r.to_s() << endl;
+  cerr << l.to_s() << endl;
+  exit(1);
+}
@@ -0,0 +1,148 @@
+#include "holang/array.hpp"
+#include "holang.hpp"
+#include "holang/arith.hpp"
+#include "holang/bind.hpp"
+#include "holang/output.hpp"
+#include "holang/string.hpp"
+#include <algorithm>
+
+using namespace holang;
+
+const std::string Array::to_s() {
+  std::string str = "[";
+  for (size_t i = 0; i < elements.size(); i++) {
+    if (i != 0) {
+      str += ", ";
+    }
+    str += elements[i].to_s();
+  }
+  return str + "]";
+}
+
+void Array::write_to(OutputBuffer &out) {
+  out.write('[');
+  for (size_t i = 0; i < elements.size(); i++) {
+    if (i != 0) {
+      out.write(", ", 2);
+    }
+    out.write(elements[i]);
+  }
+  out.write(']');
+}
+
+// "[]" and "[]=" accept negative indices counted from the end
+static Value *element(Array *array, int64_t index, const char *name) {
+  int64_t i = index < 0 ? index + (int64_t)array->elements.size() : index;
+  Value *v = array->at(i);
+  if (v == nullptr) {
+    std::cerr << "Array#" << name << ": index out of range: " << index
+              << " (size " << array->elements.size() << ")" << std::endl;
+    exit(1);
+  }
+  return v;
+}
+
+static Value array_load(Array *array, int64_t index) {
+  return *element(array, index, "[]");
+}
+
+static Value array_store(Array *array, int64_t index, Value v) {
+  return *element(array, index, "[]=") = v;
+}
+
+static int64_t array_size(Array *array) { return array->elements.size(); }
+
+static void array_push(Array *array, Args values) {
+  array->elements.insert(array->elements.end(), values.begin(),
+                         values.end());
+}
+
+static Value array_pop(Array *array) {
+  auto &elements = array->elements;
+  if (elements.empty()) {
+    std::cerr << "Array#pop: empty array" << std::endl;
+    exit(1);
+  }
+  Value last = elements.back();
+  elements.pop_back();
+  return last;
+}
+
+static void array_each(Array *array, Func *block) {
+  Value self((Object *)array);
+  auto &elements = array->elements;
+  // the block may push to the array, so do not hold iterators
+  for (size_t i = 0; i < elements.size(); i++) {
+    Value v = elements[i];
+    call_func_argc_one(&self, block, &v);
+  }
+}
+
+static Array *array_map(Array *array, Func *block) {
+  Value self((Object *)array);
+  auto &elements = array->elements;
+  std::vector<Value> mapped;
+  mapped.reserve(elements.size());
+  for (size_t i = 0; i < elements.size(); i++) {
+    Value v = elements[i];
+    mapped.push_back(call_func_argc_one(&self, block, &v));
+  }
+  return new Array(std::move(mapped));
+}
+
+static bool less_than(const Value &lhs, const Value &rhs) {
+  if (lhs.type == Type::INT && rhs.type == Type::INT) {
+    return lhs.ival < rhs.ival;
+  }
+  if (String::is_string(lhs) && String::is_string(rhs)) {
+    return ((String *)lhs.objval)->compare(*(String *)rhs.objval) < 0;
+  }
+  return binop_generic(Instruction::LESS, lhs, rhs).bval;
+}
+
+// returns a sorted copy in ascending order
+static Array *array_sort(Array *array) {
+  std::vector<Value> sorted = array->elements;
+  bool all_int = std::all_of(sorted.begin(), sorted.end(), [](const Value &v) {
+    return v.type == Type::INT;
+  });
+  if (all_int) {
+    std::sort(sorted.begin(), sorted.end(),
+              [](const Value &a, const Value &b) { return a.ival < b.ival; });
+  } else {
+    std::stable_sort(sorted.begin(), sorted.end(), less_than);
+  }
+  return new Array(std::move(sorted));
+}
+
+static Value array_sum(Array *array) {
+  Value total((int64_t)0);
+  for (const Value &v : array->elements) {
+    int64_t r;
+    if (total.type == Type::INT && v.type == Type::INT &&
+        !__builtin_add_overflow(total.ival, v.ival, &r)) {
+      total.ival = r;
+    } else {
+      total = binop_generic(Instruction::ADD, total, v);
+    }
+  }
+  return total;
+}
+
+static Array *new_array(Args values) {
+  return new Array(std::vector<Value>(values.begin(), values.end()));
+}
+
+void Array::init() {
+  // Array.new(1, 2) is [1, 2]
+  Klass::Array->methods["new"] = new Func(bind<&new_array>());
+  Klass::Array->set_method("[]", new Func(bind_method<&array_load>()));
+  Klass::Array->set_method("[]=", new Func(bind_method<&array_store>()));
+  Klass::Array->set_method("size", new Func(bind_method<&array_size>()));
+  Klass::Array->set_method("push", new Func(bind_method<&array_push>()));
+  Klass::Array->set_method("pop", new Func(bind_method<&array_pop>()));
+  Klass::Array->set_method("each", new Func(bind_method<&array_each>()));
+  Klass::Array->set_method("map", new Func(bind_method<&array_map>()));
+  Klass::Array->set_method("sort", new Func(bind_method<&array_sort>()));
+  Klass::Array->set_method("sum", new Func(bind_method<&array_sum>()));
+}
@@ -0,0 +1,348 @@
+#include "holang/bignum.hpp"
+#include "holang.hpp"
+#include "holang/bind.hpp"
+#include "holang/number.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+using namespace std;
+using namespace holang;
+
+using Digits = BigInt::Digits;
+
+// Operands with at least this many digits are multiplied with Karatsuba.
+static const size_t KARATSUBA_THRESHOLD = 32;
+
+// ----- magnitude ----- //
+
+static void trim(Digits &a) {
+  while (!a.empty() && a.back() == 0) {
+    a.pop_back();
+  }
+}
+
+static int compare_digits(const Digits &a, const Digits &b) {
+  if (a.size() != b.size()) {
+    return a.size() < b.size() ? -1 : 1;
+  }
+  for (size_t i = a.size(); i-- > 0;) {
+    if (a[i] != b[i]) {
+      return a[i] < b[i] ? -1 : 1;
+    }
+  }
+  return 0;
+}
+
+static Digits add_digits(const Digits &a, const Digits &b) {
+  const Digits &longer = a.size() >= b.size() ? a : b;
+  const Digits &shorter = a.size() >= b.size() ? b : a;
+  Digits r(longer.size() + 1);
+  uint64_t carry = 0;
+  for (size_t i = 0; i < longer.size(); i++) {
+    uint64_t sum = carry + longer[i] + (i < shorter.size() ? shorter[i] : 0);
+    r[i] = static_cast<uint32_t>(sum);
+    carry = sum >> 32;
+  }
+  r[longer.size()] = static_cast<uint32_t>(carry);
+  trim(r);
+  return r;
+}
+
+// a - b, requires a >= b
+static Digits sub_digits(const Digits &a, const Digits &b) {
+  Digits r(a.size());
+  int64_t borrow = 0;
+  for (size_t i = 0; i < a.size(); i++) {
+    int64_t diff = static_cast<int64_t>(a[i]) - borrow -
+                   (i < b.size() ? static_cast<int64_t>(b[i]) : 0);
+    borrow = diff < 0;
+    r[i] = static_cast<uint32_t>(diff + (borrow << 32));
+  }
+  trim(r);
+  return r;
+}
+
+static Digits mul_schoolbook(const Digits &a, const Digits &b) {
+  if (a.empty() || b.empty()) {
+    return Digits();
+  }
+  Digits r(a.size() + b.size());
+  for (size_t i = 0; i < a.size(); i++) {
+    uint64_t carry = 0;
+    for (size_t j = 0; j < b.size(); j++) {
+      uint64_t t = static_cast<uint64_t>(a[i]) * b[j] + r[i + j] + carry;
+      r[i + j] = static_cast<uint32_t>(t);
+      carry = t >> 32;
+    }
+    r[i + b.size()] = static_cast<uint32_t>(carry);
+  }
+  trim(r);
+  return r;
+}
+
+static Digits shifted(const Digits &a, size_t digits) {
+  if (a.empty()) {
+    return a;
+  }
+  Digits r(digits, 0);
+  r.insert(r.end(), a.begin(), a.end());
+  return r;
+}
+
+static Digits mul_digits(const Digits &a, const Digits &b) {
+  if (a.size() < KARATSUBA_THRESHOLD || b.size() < KARATSUBA_THRESHOLD) {
+    return mul_schoolbook(a, b);
+  }
+
+  // a = a1 * B^m + a0, b = b1 * B^m + b0
+  // a * b = z2 * B^2m + (z1 - z2 - z0) * B^m + z0
+  size_t m = max(a.size(), b.size()) / 2;
+  auto low = [m](const Digits &x) {
+    Digits r(x.begin(), x.begin() + min(m, x.size()));
+    trim(r);
+    return r;
+  };
+  auto high = [m](const Digits &x) {
+    return x.size() > m ? Digits(x.begin() + m, x.end()) : Digits();
+  };
+  Digits a0 = low(a), a1 = high(a);
+  Digits b0 = low(b), b1 = high(b);
+
+  Digits z0 = mul_digits(a0, b0);
+  Digits z2 = mul_digits(a1, b1);
+  Digits z1 = mul_digits(add_digits(a0, a1), add_digits(b0, b1));
+  z1 = sub_digits(sub_digits(z1, z2), z0);
+
+  return add_digits(add_digits(shifted(z2, 2 * m), shifted(z1, m)), z0);
+}
+
+static uint32_t divmod_small(Digits &a, uint32_t d) {
+  uint64_t rem = 0;
+  for (size_t i = a.size(); i-- > 0;) {
+    uint64_t cur = (rem << 32) | a[i];
+    a[i] = static_cast<uint32_t>(cur / d);
+    rem = cur % d;
+  }
+  trim(a);
+  return static_cast<uint32_t>(rem);
+}
+
+// Knuth's algorithm D (TAOCP 4.3.1)
+static void divmod_digits(const Digits &u, const Digits &v, Digits &q,
+                          Digits &r) {
+  if (compare_digits(u, v) < 0) {
+    q.clear();
+    r = u;
+    return;
+  }
+  if (v.size() == 1) {
+    q = u;
+    uint32_t rem = divmod_small(q, v[0]);
+    r = rem == 0 ? Digits() : Digits{rem};
+    return;
+  }
+
+  const size_t n = v.size();
+  const size_t m = u.size();
+  const int s = __builtin_clz(v.back());
+  const uint64_t base = uint64_t(1) << 32;
+
+  Digits vn(n), un(m + 1);
+  for (size_t i = n - 1; i > 0; i--) {
+    vn[i] = (v[i] << s) | (s == 0 ? 0 : v[i - 1] >> (32 - s));
+  }
+  vn[0] = v[0] << s;
+  un[m] = s == 0 ? 0 : u[m - 1] >> (32 - s);
+  for (size_t i = m - 1; i > 0; i--) {
+    un[i] = (u[i] << s) | (s == 0 ? 0 : u[i - 1] >> (32 - s));
+  }
+  un[0] = u[0] << s;
+
+  q.assign(m - n + 1, 0);
+  for (size_t j = m - n + 1; j-- > 0;) {
+    uint64_t num = (static_cast<uint64_t>(un[j + n]) << 32) | un[j + n - 1];
+    uint64_t qhat = num / vn[n - 1];
+    uint64_t rhat = num % vn[n - 1];
+    while (qhat >= base || qhat * vn[n - 2] > ((rhat << 32) | un[j + n - 2])) {
+      qhat--;
+      rhat += vn[n - 1];
+      if (rhat >= base) {
+        break;
+      }
+    }
+
+    int64_t borrow = 0;
+    for (size_t i = 0; i < n; i++) {
+      uint64_t p = qhat * vn[i];
+      int64_t t = static_cast<int64_t>(un[i + j]) - borrow -
+                  static_cast<int64_t>(p & 0xFFFFFFFF);
+      un[i + j] = static_cast<uint32_t>(t);
+      borrow = static_cast<int64_t>(p >> 32) - (t >> 32);
+    }
+    int64_t t = static_cast<int64_t>(un[j + n]) - borrow;
+    un[j + n] = static_cast<uint32_t>(t);
+
+    q[j] = static_cast<uint32_t>(qhat);
+    if (t < 0) {
+      q[j]--;
+      uint64_t carry = 0;
+      for (size_t i = 0; i < n; i++) {
+        uint64_t sum = static_cast<uint64_t>(un[i + j]) + vn[i] + carry;
+        un[i + j] = static_cast<uint32_t>(sum);
+        carry = sum >> 32;
+      }
+      un[j + n] += static_cast<uint32_t>(carry);
+    }
+  }
+  trim(q);
+
+  r.assign(n, 0);
+  for (size_t i = 0; i < n; i++) {
+    r[i] = (un[i] >> s) | (s == 0 ? 0 : un[i + 1] << (32 - s));
+  }
+  trim(r);
+}
+
+// ----- BigInt ----- //
+
+namespace {
+// sign and magnitude of an int Value or a BigInt
+struct Operand {
+  bool negative;
+  const Digits *digits;
+  Digits int_digits;
+
+  Operand(const Value &v) {
+    if (v.type == Type::INT) {
+      negative = v.ival < 0;
+      uint64_t mag = negative ? 0 - static_cast<uint64_t>(v.ival) : v.ival;
+      while (mag != 0) {
+        int_digits.push_back(static_cast<uint32_t>(mag));
+        mag >>= 32;
+      }
+      digits = &int_digits;
+    } else {
+      auto *big = static_cast<BigInt *>(v.objval);
+      negative = big->is_negative();
+      digits = &big->get_digits();
+    }
+  }
+};
+} // namespace
+
+BigInt::BigInt(bool negative, Digits &&digits)
+    : negative(negative), digits(std::move(digits)) {
+  klass = Klass::BigInt;
+}
+
+Value BigInt::normalize(bool negative, Digits &&digits) {
+  trim(digits);
+  if (digits.size() <= 2) {
+    uint64_t mag = 0;
+    for (size_t i = digits.size(); i-- > 0;) {
+      mag = (mag << 32) | digits[i];
+    }
+    if (!negative && mag <= static_cast<uint64_t>(INT64_MAX)) {
+      return Value(static_cast<int64_t>(mag));
+    }
+    if (negative && mag <= static_cast<uint64_t>(INT64_MAX) + 1) {
+      return Value(static_cast<int64_t>(0 - mag));
+    }
+  }
+  return Value((Object *)new BigInt(negative, std::move(digits)));
+}
+
+static Value add_signed(const Operand &a, const Operand &b, bool b_negative) {
+  if (a.negative == b_negative) {
+    return BigInt::normalize(a.negative, add_digits(*a.digits, *b.digits));
+  }
+  if (compare_digits(*a.digits, *b.digits) >= 0) {
+    return BigInt::normalize(a.negative, sub_digits(*a.digits, *b.digits));
+  }
+  return BigInt::normalize(b_negative, sub_digits(*b.digits, *a.digits));
+}
+
+Value BigInt::add(const Value &lhs, const Value &rhs) {
+  Operand a(lhs), b(rhs);
+  return add_signed(a, b, b.negative);
+}
+
+Value BigInt::sub(const Value &lhs, const Value &rhs) {
+  Operand a(lhs), b(rhs);
+  return add_signed(a, b, !b.negative);
+}
+
+Value BigInt::mul(const Value &lhs, const Value &rhs) {
+  Operand a(lhs), b(rhs);
+  return normalize(a.negative != b.negative, mul_digits(*a.digits, *b.digits));
+}
+
+static void divmod(const Value &lhs, const Value &rhs, Digits &q, Digits &r,
+                   bool &q_negative, bool &r_negative) {
+  Operand a(lhs), b(rhs);
+  if (b.digits->empty()) {
+    std::cerr << "divided by 0" << std::endl;
+    exit(1);
+  }
+  divmod_digits(*a.digits, *b.digits, q, r);
+  q_negative = a.negative != b.negative;
+  r_negative = a.negative;
+}
+
+Value BigInt::div(const Value &lhs, const Value &rhs) {
+  Digits q, r;
+  bool q_negative, r_negative;
+  divmod(lhs, rhs, q, r, q_negative, r_negative);
+  return normalize(q_negative, std::move(q));
+}
+
+Value BigInt::mod(const Value &lhs, const Value &rhs) {
+  Digits q, r;
+  bool q_negative, r_negative;
+  divmod(lhs, rhs, q, r, q_negative, r_negative);
+  return normalize(r_negative, std::move(r));
+}
+
+int BigInt::compare(const Value &lhs, const Value &rhs) {
+  Operand a(lhs), b(rhs);
+  if (a.negative != b.negative) {
+    return a.negative ? -1 : 1;
+  }
+  int cmp = compare_digits(*a.digits, *b.digits);
+  return a.negative ? -cmp : cmp;
+}
+
+double BigInt::to_double(const Value &v) {
+  Operand a(v);
+  double d = 0;
+  for (size_t i = a.digits->size(); i-- > 0;) {
+    d = d * 4294967296.0 + (*a.digits)[i];
+  }
+  return a.negative ? -d : d;
+}
+
+const std::string BigInt::to_s() {
+  // split into base 10^9 chunks, least significant first
+  Digits rest = digits;
+  std::vector<uint32_t> chunks;
+  while (!rest.empty()) {
+    chunks.push_back(divmod_small(rest, 1000000000));
+  }
+
+  std::string str = negative ? "-" : "";
+  char buf[INT_CHARS_MAX];
+  str.append(buf, format_int(buf, chunks.back()));
+  for (size_t i = chunks.size() - 1; i-- > 0;) {
+    char *end = format_int(buf, chunks[i]);
+    str.append(9 - (end - buf), '0');
+    str.append(buf, end);
+  }
+  return str;
+}
+
+static double bigint_to_f(Value self) { return BigInt::to_double(self); }
+
+void BigInt::init() {
+  Klass::BigInt->set_method("to_f", new Func(bind_method<&bigint_to_f>()));
+}
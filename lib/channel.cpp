@@ -0,0 +1,453 @@
+#include "holang/channel.hpp"
+#include "holang/array.hpp"
+#include "holang/bignum.hpp"
+#include "holang/bind_builtins.hpp"
+#include "holang/hash.hpp"
+#include "holang/range.hpp"
+#include "holang/string.hpp"
+#include "holang/vm.hpp"
+#include <thread>
+
+using namespace holang;
+
+// How many times a blocked operation retries before it sleeps.
+static const int BLOCKING_SPINS = 64;
+
+// ----- Message ----- //
+
+Message Message::pack(const Value &value, const char *who) {
+  Message m;
+  switch (value.type) {
+  case Type::INT:
+    m.kind = Kind::INT;
+    m.ival = value.ival;
+    return m;
+  case Type::DOUBLE:
+    m.kind = Kind::DOUBLE;
+    m.dval = value.dval;
+    return m;
+  case Type::BOOL:
+    m.kind = Kind::BOOL;
+    m.bval = value.bval;
+    return m;
+  case Type::FUNCTION:
+    break;
+  case Type::OBJECT:
+    if (String::is_string(value)) {
+      auto *str = (String *)value.objval;
+      m.kind = Kind::STRING;
+      m.size = str->size();
+      m.buffer = str->get_buffer();
+      if (m.buffer != nullptr) {
+        m.chars = str->data();
+      } else {
+        m.bytes.assign(str->data(), str->size());
+      }
+      return m;
+    }
+    if (BigInt::is_bigint(value)) {
+      auto *big = (BigInt *)value.objval;
+      m.kind = Kind::BIGINT;
+      m.bval = big->is_negative();
+      m.digits = big->get_digits();
+      return m;
+    }
+    if (Range::is_range(value)) {
+      auto *range = (Range *)value.objval;
+      m.kind = Kind::RANGE;
+      m.ival = range->first;
+      m.last = range->last;
+      return m;
+    }
+    if (Array::is_array(value)) {
+      auto *array = (Array *)value.objval;
+      m.kind = Kind::ARRAY;
+      m.elements.reserve(array->elements.size());
+      for (const Value &element : array->elements) {
+        m.elements.push_back(pack(element, who));
+      }
+      return m;
+    }
+    if (Hash::is_hash(value)) {
+      auto *hash = (Hash *)value.objval;
+      m.kind = Kind::HASH;
+      m.elements.reserve(hash->size() * 2);
+      for (const Hash::Entry &entry : hash->get_entries()) {
+        if (entry.live) {
+          m.elements.push_back(pack(entry.key, who));
+          m.elements.push_back(pack(entry.value, who));
+        }
+      }
+      return m;
+    }
+    if (Channel::is_channel(value)) {
+      m.kind = Kind::CHANNEL;
+      m.channel = ((Channel *)value.objval)->get_queue();
+      return m;
+    }
+    break;
+  }
+  Value v = value;
+  std::cerr << who << ": can not send " << v.to_s() << std::endl;
+  exit(1);
+}
+
+Value Message::unpack() const {
+  switch (kind) {
+  case Kind::INT:
+    return Value(ival);
+  case Kind::DOUBLE:
+    return Value(dval);
+  case Kind::BOOL:
+    return Value(bval);
+  case Kind::STRING:
+    if (buffer != nullptr) {
+      return Value((Object *)String::view(buffer, chars, size));
+    }
+    return Value((Object *)new String(bytes.data(), bytes.size()));
+  case Kind::BIGINT:
+    return Value((Object *)new BigInt(bval, BigInt::Digits(digits)));
+  case Kind::RANGE:
+    return Value((Object *)new Range(ival, last));
+  case Kind::ARRAY: {
+    std::vector<Value> values;
+    values.reserve(elements.size());
+    for (const Message &element : elements) {
+      values.push_back(element.unpack());
+    }
+    return Value((Object *)new Array(std::move(values)));
+  }
+  case Kind::HASH: {
+    auto *hash = new Hash();
+    for (size_t i = 0; i + 1 < elements.size(); i += 2) {
+      hash->insert(elements[i].unpack(), elements[i + 1].unpack());
+    }
+    return Value((Object *)hash);
+  }
+  case Kind::CHANNEL:
+    return Value((Object *)new Channel(channel));
+  }
+  return Value(false);
+}
+
+// ----- ChannelQueue ----- //
+
+static size_t round_up_to_power_of_two(size_t n) {
+  size_t p = 2;
+  while (p < n) {
+    p *= 2;
+  }
+  return p;
+}
+
+ChannelQueue::ChannelQueue(size_t capacity)
+    : slots(new Slot[round_up_to_power_of_two(capacity)]),
+      mask(round_up_to_power_of_two(capacity) - 1), capacity(capacity) {
+  for (size_t i = 0; i <= mask; i++) {
+    slots[i].seq.store(i, std::memory_order_relaxed);
+  }
+}
+
+ChannelQueue::Status ChannelQueue::try_push(Message &&message) {
+  size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+  Slot *slot;
+  while (true) {
+    if ((pos & CLOSED_BIT) != 0) {
+      return Status::CLOSED;
+    }
+    // signed: consumers may have moved past the position read
+    size_t popped = dequeue_pos.load(std::memory_order_acquire);
+    if ((intptr_t)(pos - popped) >= (intptr_t)capacity) {
+      return Status::FULL;
+    }
+    slot = &slots[pos & mask];
+    size_t seq = slot->seq.load(std::memory_order_acquire);
+    intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+    if (diff == 0) {
+      // the slot is free for this position: claim it
+      if (enqueue_pos.compare_exchange_weak(pos, pos + 1,
+                                            std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // the consumer of the previous lap has not taken it yet
+      return Status::FULL;
+    } else {
+      pos = enqueue_pos.load(std::memory_order_relaxed);
+    }
+  }
+  slot->message = std::move(message);
+  slot->seq.store(pos + 1, std::memory_order_release);
+  notify();
+  return Status::OK;
+}
+
+bool ChannelQueue::take(Message &message) {
+  size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+  Slot *slot;
+  while (true) {
+    slot = &slots[pos & mask];
+    size_t seq = slot->seq.load(std::memory_order_acquire);
+    intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+    if (diff == 0) {
+      if (dequeue_pos.compare_exchange_weak(pos, pos + 1,
+                                            std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      return false;
+    } else {
+      pos = dequeue_pos.load(std::memory_order_relaxed);
+    }
+  }
+  message = std::move(slot->message);
+  slot->message = Message();
+  // free for the producer of the next lap
+  slot->seq.store(pos + mask + 1, std::memory_order_release);
+  notify();
+  return true;
+}
+
+ChannelQueue::Status ChannelQueue::try_pop(Message &message) {
+  if (take(message)) {
+    return Status::OK;
+  }
+  size_t end = enqueue_pos.load(std::memory_order_acquire);
+  if ((end & CLOSED_BIT) == 0) {
+    return Status::EMPTY;
+  }
+  // every push which took a position before close() is popped, even one
+  // still storing its message, which wakes the waiters when it is done
+  if (dequeue_pos.load(std::memory_order_acquire) >= (end & ~CLOSED_BIT)) {
+    return Status::CLOSED;
+  }
+  return take(message) ? Status::OK : Status::EMPTY;
+}
+
+ChannelQueue::Status ChannelQueue::push(Message &&message) {
+  Status status;
+  for (int i = 0; i < BLOCKING_SPINS; i++) {
+    status = try_push(std::move(message));
+    if (status != Status::FULL) {
+      return status;
+    }
+    std::this_thread::yield();
+  }
+  Waiter waiter;
+  add_waiter(&waiter);
+  while ((status = try_push(std::move(message))) == Status::FULL) {
+    waiter.wait();
+  }
+  remove_waiter(&waiter);
+  return status;
+}
+
+ChannelQueue::Status ChannelQueue::pop(Message &message) {
+  Status status;
+  for (int i = 0; i < BLOCKING_SPINS; i++) {
+    status = try_pop(message);
+    if (status != Status::EMPTY) {
+      return status;
+    }
+    std::this_thread::yield();
+  }
+  Waiter waiter;
+  add_waiter(&waiter);
+  while ((status = try_pop(message)) == Status::EMPTY) {
+    waiter.wait();
+  }
+  remove_waiter(&waiter);
+  return status;
+}
+
+void ChannelQueue::close() {
+  enqueue_pos.fetch_or(CLOSED_BIT, std::memory_order_acq_rel);
+  notify();
+}
+
+void ChannelQueue::Waiter::wait() {
+  std::unique_lock<std::mutex> lock(mutex);
+  changed.wait(lock, [this] { return signaled; });
+  signaled = false;
+}
+
+void ChannelQueue::add_waiter(Waiter *waiter) {
+  {
+    std::lock_guard<std::mutex> lock(waiters_mutex);
+    waiters.push_back(waiter);
+  }
+  waiter_count.fetch_add(1);
+  // pairs with the fence in notify(): either the waiter's next retry sees
+  // the change, or notify() sees the waiter
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+void ChannelQueue::remove_waiter(Waiter *waiter) {
+  std::lock_guard<std::mutex> lock(waiters_mutex);
+  for (size_t i = 0; i < waiters.size(); i++) {
+    if (waiters[i] == waiter) {
+      waiters.erase(waiters.begin() + i);
+      break;
+    }
+  }
+  waiter_count.fetch_sub(1);
+}
+
+void ChannelQueue::notify() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (waiter_count.load(std::memory_order_relaxed) == 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(waiters_mutex);
+  for (Waiter *waiter : waiters) {
+    {
+      std::lock_guard<std::mutex> waiter_lock(waiter->mutex);
+      waiter->signaled = true;
+    }
+    waiter->changed.notify_one();
+  }
+}
+
+// ----- Channel ----- //
+
+Channel::Channel(std::shared_ptr<ChannelQueue> queue)
+    : queue(std::move(queue)) {
+  klass = Klass::Channel;
+}
+
+static void exit_by_closed(const char *who) {
+  std::cerr << who << ": the channel is closed" << std::endl;
+  exit(1);
+}
+
+// Channel.new(capacity)
+static Channel *new_channel(int64_t capacity) {
+  if (capacity < 1) {
+    std::cerr << "Channel.new: capacity must be a positive Int" << std::endl;
+    exit(1);
+  }
+  return new Channel(std::make_shared<ChannelQueue>(capacity));
+}
+
+// send(v): waits while the channel is full
+static bool channel_send(Channel *channel, Value v) {
+  Message m = Message::pack(v, "Channel#send");
+  if (channel->get_queue()->push(std::move(m)) ==
+      ChannelQueue::Status::CLOSED) {
+    exit_by_closed("Channel#send");
+  }
+  return true;
+}
+
+// try_send(v): false when the channel is full
+static bool channel_try_send(Channel *channel, Value v) {
+  Message m = Message::pack(v, "Channel#try_send");
+  ChannelQueue::Status status = channel->get_queue()->try_push(std::move(m));
+  if (status == ChannelQueue::Status::CLOSED) {
+    exit_by_closed("Channel#try_send");
+  }
+  return status == ChannelQueue::Status::OK;
+}
+
+// recv: waits for a value; false once the channel is closed and drained
+static Value channel_recv(Channel *channel) {
+  Message m;
+  if (channel->get_queue()->pop(m) == ChannelQueue::Status::CLOSED) {
+    return Value(false);
+  }
+  return m.unpack();
+}
+
+// try_recv: [value], or [] when nothing is queued
+static Array *channel_try_recv(Channel *channel) {
+  Message m;
+  auto *result = new Array();
+  if (channel->get_queue()->try_pop(m) == ChannelQueue::Status::OK) {
+    result->elements.push_back(m.unpack());
+  }
+  return result;
+}
+
+// each { |v| }: every value until the channel is closed and drained
+static void channel_each(Channel *channel, Func *block) {
+  Value self((Object *)channel);
+  ChannelQueue &queue = *channel->get_queue();
+  Message m;
+  while (queue.pop(m) == ChannelQueue::Status::OK) {
+    Value v = m.unpack();
+    call_func_argc_one(&self, block, &v);
+  }
+}
+
+static bool channel_close(Channel *channel) {
+  channel->get_queue()->close();
+  return true;
+}
+
+static bool channel_closed(Channel *channel) {
+  return channel->get_queue()->is_closed();
+}
+
+Value Channel::select(Value *channels, int count) {
+  std::vector<ChannelQueue *> queues;
+  for (int i = 0; i < count; i++) {
+    if (!is_channel(channels[i])) {
+      std::cerr << "select: Channels required" << std::endl;
+      exit(1);
+    }
+    queues.push_back(((Channel *)channels[i].objval)->get_queue().get());
+  }
+  if (queues.empty()) {
+    std::cerr << "select: Channels required" << std::endl;
+    exit(1);
+  }
+
+  auto poll = [&](Value &result) {
+    for (size_t i = 0; i < queues.size(); i++) {
+      Message m;
+      ChannelQueue::Status status = queues[i]->try_pop(m);
+      if (status == ChannelQueue::Status::EMPTY) {
+        continue;
+      }
+      Value value = status == ChannelQueue::Status::OK ? m.unpack()
+                                                       : Value(false);
+      std::vector<Value> pair = {Value((int64_t)i), value};
+      result = Value((Object *)new Array(std::move(pair)));
+      return true;
+    }
+    return false;
+  };
+
+  Value result;
+  for (int i = 0; i < BLOCKING_SPINS; i++) {
+    if (poll(result)) {
+      return result;
+    }
+    std::this_thread::yield();
+  }
+  ChannelQueue::Waiter waiter;
+  for (ChannelQueue *queue : queues) {
+    queue->add_waiter(&waiter);
+  }
+  while (!poll(result)) {
+    waiter.wait();
+  }
+  for (ChannelQueue *queue : queues) {
+    queue->remove_waiter(&waiter);
+  }
+  return result;
+}
+
+void Channel::init() {
+  Klass::Channel->methods["new"] = new Func(bind<&new_channel>());
+  Klass::Channel->set_method("send", new Func(bind_method<&channel_send>()));
+  Klass::Channel->set_method("try_send",
+                             new Func(bind_method<&channel_try_send>()));
+  Klass::Channel->set_method("recv", new Func(bind_method<&channel_recv>()));
+  Klass::Channel->set_method("try_recv",
+                             new Func(bind_method<&channel_try_recv>()));
+  Klass::Channel->set_method("each", new Func(bind_method<&channel_each>()));
+  Klass::Channel->set_method("close", new Func(bind_method<&channel_close>()));
+  Klass::Channel->set_method("closed",
+                             new Func(bind_method<&channel_closed>()));
+}
@@ -0,0 +1,95 @@
+#include "holang/coroutine.hpp"
+#include "holang/array.hpp"
+#include "holang/bind_builtins.hpp"
+#include "holang/vm.hpp"
+
+using namespace holang;
+
+Coroutine::Coroutine(Func *func, Value self, Value *args, int argc)
+    : func(func), self(self), args(args, args + argc) {
+  klass = Klass::Coroutine;
+}
+
+Coroutine::~Coroutine() {}
+
+bool Coroutine::resume(Value *resume_args, int argc, Value &out) {
+  if (done) {
+    std::cerr << "Coroutine#resume: the coroutine has finished" << std::endl;
+    exit(1);
+  }
+  if (running) {
+    std::cerr << "Coroutine#resume: the coroutine is running" << std::endl;
+    exit(1);
+  }
+
+  running = true;
+  bool yielded;
+  if (vm == nullptr) {
+    args.insert(args.end(), resume_args, resume_args + argc);
+    vm.reset(new HolangVM(func, self, args.data(), args.size()));
+    args.clear();
+    yielded = vm->resume(nullptr, out);
+  } else {
+    Value sent = argc > 0 ? resume_args[0] : Value(false);
+    yielded = vm->resume(&sent, out);
+  }
+  running = false;
+  if (!yielded) {
+    done = true;
+    value = out;
+    vm.reset();
+  }
+  return yielded;
+}
+
+// resume(args...): the next yielded value, or the returned one at the end
+static Value coroutine_resume(Coroutine *co, Args args) {
+  Value out;
+  co->resume(args.values, args.count, out);
+  return out;
+}
+
+static bool coroutine_done(Coroutine *co) { return co->is_done(); }
+
+// value: what the body returned, once done
+static Value coroutine_value(Coroutine *co) {
+  if (!co->is_done()) {
+    std::cerr << "Coroutine#value: the coroutine has not finished"
+              << std::endl;
+    exit(1);
+  }
+  return co->get_value();
+}
+
+// each { |v| }: every value yielded from here on
+static void coroutine_each(Coroutine *co, Func *block) {
+  Value self((Object *)co);
+  Value v;
+  while (!co->is_done() && co->resume(nullptr, 0, v)) {
+    call_func_argc_one(&self, block, &v);
+  }
+}
+
+static Array *coroutine_to_a(Coroutine *co) {
+  auto *array = new Array();
+  Value v;
+  while (!co->is_done() && co->resume(nullptr, 0, v)) {
+    array->elements.push_back(v);
+  }
+  return array;
+}
+
+void Coroutine::init() {
+  Klass::Coroutine->set_method("resume",
+                               new Func(bind_method<&coroutine_resume>()));
+  Klass::Coroutine->set_method("next",
+                               new Func(bind_method<&coroutine_resume>()));
+  Klass::Coroutine->set_method("done",
+                               new Func(bind_method<&coroutine_done>()));
+  Klass::Coroutine->set_method("value",
+                               new Func(bind_method<&coroutine_value>()));
+  Klass::Coroutine->set_method("each",
+                               new Func(bind_method<&coroutine_each>()));
+  Klass::Coroutine->set_method("to_a",
+                               new Func(bind_method<&coroutine_to_a>()));
+}
@@ -0,0 +1,471 @@
+#include "holang/event_loop.hpp"
+#include "holang/array.hpp"
+#include "holang/bind_builtins.hpp"
+#include "holang/coroutine.hpp"
+#include "holang/vm.hpp"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace holang;
+
+// the most bytes returned by one Stream#read
+static const size_t READ_SIZE = 1 << 16;
+static const int MAX_EVENTS = 256;
+
+// the loop running IO.run() on this thread
+static thread_local EventLoop *driving = nullptr;
+
+static void exit_by_errno(const char *what) {
+  std::cerr << what << ": " << strerror(errno) << std::endl;
+  exit(1);
+}
+
+EventLoop::EventLoop() {
+  epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (epoll_fd < 0) {
+    exit_by_errno("epoll_create1");
+  }
+}
+
+EventLoop::~EventLoop() { ::close(epoll_fd); }
+
+void EventLoop::start(Coroutine *task) {
+  tasks++;
+  ready.push_back({task, Value(false), 0});
+}
+
+void EventLoop::run() {
+  if (running) {
+    std::cerr << "IO.run: the loop is already running" << std::endl;
+    exit(1);
+  }
+  running = true;
+  EventLoop *outer = driving;
+  driving = this;
+
+  while (tasks > 0) {
+    while (!ready.empty()) {
+      Ready next = ready.front();
+      ready.pop_front();
+      resume(next);
+    }
+    if (tasks == 0) {
+      break;
+    }
+    if (waiting == 0 && timers.empty()) {
+      std::cerr << "IO.run: " << tasks
+                << " task(s) were suspended outside the loop" << std::endl;
+      exit(1);
+    }
+    poll(next_timeout());
+    expire_timers();
+  }
+
+  driving = outer;
+  running = false;
+}
+
+void EventLoop::resume(Ready &next) {
+  Coroutine *task = next.task;
+  running_task = task;
+  task_suspended = false;
+  Value out;
+  bool yielded = task->resume(&next.value, next.argc, out);
+  running_task = nullptr;
+  if (!yielded) {
+    tasks--;
+  } else if (!task_suspended) {
+    // a plain yield gives the other tasks a turn
+    ready.push_back({task, Value(false), 1});
+  }
+}
+
+EventLoop *EventLoop::suspendable() {
+  EventLoop *loop = driving;
+  if (loop == nullptr || loop->running_task == nullptr) {
+    return nullptr;
+  }
+  HolangVM *vm = HolangVM::current();
+  if (vm == nullptr || vm != loop->running_task->get_vm() ||
+      !vm->can_suspend()) {
+    return nullptr;
+  }
+  return loop;
+}
+
+void EventLoop::suspend(Wait &&wait) {
+  int fd = wait.stream->get_fd();
+  auto inserted = watches.emplace(fd, Watch());
+  if (inserted.second) {
+    struct epoll_event ev;
+    ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    ev.data.fd = fd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+      exit_by_errno("epoll_ctl");
+    }
+  }
+  Watch &watch = inserted.first->second;
+  bool reads = wait.op == Op::READ || wait.op == Op::ACCEPT;
+  Wait &slot = reads ? watch.reader : watch.writer;
+  if (slot.task != nullptr) {
+    std::cerr << "Stream: another task is already waiting to "
+              << (reads ? "read" : "write") << std::endl;
+    exit(1);
+  }
+  slot = std::move(wait);
+  slot.task = running_task;
+  waiting++;
+  task_suspended = true;
+  HolangVM::current()->suspend_call();
+}
+
+void EventLoop::suspend_for(std::chrono::milliseconds duration) {
+  timers.push({Clock::now() + duration, timer_seq++, running_task});
+  task_suspended = true;
+  HolangVM::current()->suspend_call();
+}
+
+void EventLoop::forget(int fd) {
+  auto it = watches.find(fd);
+  if (it == watches.end()) {
+    return;
+  }
+  for (Wait *wait : {&it->second.reader, &it->second.writer}) {
+    if (wait->task != nullptr) {
+      ready.push_back({wait->task, Value(false), 1});
+      waiting--;
+    }
+  }
+  watches.erase(it);
+  epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+int EventLoop::next_timeout() const {
+  if (!ready.empty()) {
+    return 0;
+  }
+  if (timers.empty()) {
+    return -1;
+  }
+  auto left = timers.top().deadline - Clock::now();
+  if (left <= Clock::duration::zero()) {
+    return 0;
+  }
+  // rounded up so that the timer has expired when epoll_wait returns
+  auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+      left + std::chrono::milliseconds(1) - Clock::duration(1));
+  return static_cast<int>(ms.count());
+}
+
+void EventLoop::poll(int timeout_ms) {
+  struct epoll_event events[MAX_EVENTS];
+  int n = epoll_wait(epoll_fd, events, MAX_EVENTS, timeout_ms);
+  if (n < 0) {
+    if (errno == EINTR) {
+      return;
+    }
+    exit_by_errno("epoll_wait");
+  }
+  for (int i = 0; i < n; i++) {
+    auto it = watches.find(events[i].data.fd);
+    if (it == watches.end()) {
+      continue;
+    }
+    uint32_t ev = events[i].events;
+    if (ev & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+      complete(it->second.reader);
+    }
+    if (ev & (EPOLLOUT | EPOLLHUP | EPOLLERR)) {
+      complete(it->second.writer);
+    }
+  }
+}
+
+void EventLoop::complete(Wait &wait) {
+  Value result;
+  // with edge-triggered events a readiness nobody waits for is dropped;
+  // the next operation tries the descriptor before waiting anyway
+  if (wait.task == nullptr || !attempt(wait, result)) {
+    return;
+  }
+  ready.push_back({wait.task, result, 1});
+  wait = Wait();
+  waiting--;
+}
+
+void EventLoop::expire_timers() {
+  auto now = Clock::now();
+  while (!timers.empty() && timers.top().deadline <= now) {
+    ready.push_back({timers.top().task, Value(true), 1});
+    timers.pop();
+  }
+}
+
+bool EventLoop::attempt(Wait &wait, Value &result) {
+  int fd = wait.stream->get_fd();
+  if (fd < 0) {
+    std::cerr << "Stream: already closed" << std::endl;
+    exit(1);
+  }
+
+  switch (wait.op) {
+  case Op::READ: {
+    char buf[READ_SIZE];
+    while (true) {
+      ssize_t n = ::read(fd, buf, sizeof(buf));
+      if (n >= 0) {
+        result = Value((Object *)new String(buf, n));
+        return true;
+      }
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        return false;
+      }
+      if (errno == ECONNRESET) {
+        // the peer is gone: end of stream
+        result = Value((Object *)new String(""));
+        return true;
+      }
+      if (errno != EINTR) {
+        exit_by_errno("Stream#read");
+      }
+    }
+  }
+  case Op::WRITE:
+    while (wait.written < (int64_t)wait.data.size()) {
+      const char *p = wait.data.data() + wait.written;
+      size_t len = wait.data.size() - wait.written;
+      ssize_t n = wait.stream->is_socket() ? send(fd, p, len, MSG_NOSIGNAL)
+                                           : ::write(fd, p, len);
+      if (n < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+          return false;
+        }
+        if (errno != EINTR) {
+          exit_by_errno("Stream#write");
+        }
+        continue;
+      }
+      wait.written += n;
+    }
+    result = Value(wait.written);
+    return true;
+  case Op::ACCEPT:
+    while (true) {
+      int conn = accept4(fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+      if (conn >= 0) {
+        int one = 1;
+        setsockopt(conn, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        result = Value((Object *)new Stream(conn, true));
+        return true;
+      }
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        return false;
+      }
+      if (errno != EINTR && errno != ECONNABORTED) {
+        exit_by_errno("Stream#accept");
+      }
+    }
+  case Op::CONNECT: {
+    struct pollfd pfd = {fd, POLLOUT, 0};
+    if (::poll(&pfd, 1, 0) == 0) {
+      return false;
+    }
+    int error = 0;
+    socklen_t len = sizeof(error);
+    getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len);
+    if (error != 0) {
+      errno = error;
+      exit_by_errno("IO.connect");
+    }
+    result = Value((Object *)wait.stream);
+    return true;
+  }
+  }
+  return false;
+}
+
+// Performs the operation, suspending the running task or blocking the
+// thread until the descriptor is ready.
+static Value perform(EventLoop::Wait &&wait) {
+  Value result;
+  while (!EventLoop::attempt(wait, result)) {
+    EventLoop *loop = EventLoop::suspendable();
+    if (loop != nullptr) {
+      loop->suspend(std::move(wait));
+      // replaced by the result when the loop resumes the task
+      return Value(false);
+    }
+    bool reads =
+        wait.op == EventLoop::Op::READ || wait.op == EventLoop::Op::ACCEPT;
+    struct pollfd pfd = {wait.stream->get_fd(),
+                         (short)(reads ? POLLIN : POLLOUT), 0};
+    ::poll(&pfd, 1, -1);
+  }
+  return result;
+}
+
+// ----- Stream ----- //
+
+Stream::Stream(int fd, bool socket) : fd(fd), socket(socket) {
+  klass = Klass::Stream;
+}
+
+void Stream::close() {
+  if (fd < 0) {
+    return;
+  }
+  Isolate::current()->event_loop().forget(fd);
+  ::close(fd);
+  fd = -1;
+}
+
+static Value stream_op(Stream *stream, EventLoop::Op op) {
+  EventLoop::Wait wait;
+  wait.stream = stream;
+  wait.op = op;
+  return perform(std::move(wait));
+}
+
+// read: the bytes available, waiting for some; "" at the end of the stream
+static Value stream_read(Stream *stream) {
+  return stream_op(stream, EventLoop::Op::READ);
+}
+
+// write(values...): writes all of them and returns the number of bytes
+static Value stream_write(Stream *stream, Args values) {
+  EventLoop::Wait wait;
+  wait.stream = stream;
+  wait.op = EventLoop::Op::WRITE;
+  for (Value &v : values) {
+    if (String::is_string(v)) {
+      auto *str = (String *)v.objval;
+      wait.data.append(str->data(), str->size());
+    } else {
+      wait.data += v.to_s();
+    }
+  }
+  return perform(std::move(wait));
+}
+
+// accept: the Stream of the next connection to a listening socket
+static Value stream_accept(Stream *stream) {
+  return stream_op(stream, EventLoop::Op::ACCEPT);
+}
+
+static bool stream_close(Stream *stream) {
+  stream->close();
+  return true;
+}
+
+// port: the local port of a socket, e.g. of IO.listen(0)
+static int64_t stream_port(Stream *stream) {
+  struct sockaddr_in addr;
+  socklen_t len = sizeof(addr);
+  if (getsockname(stream->get_fd(), (struct sockaddr *)&addr, &len) < 0) {
+    exit_by_errno("Stream#port");
+  }
+  return ntohs(addr.sin_port);
+}
+
+// ----- IO ----- //
+
+static int port_arg(const char *name, int64_t port) {
+  if (port < 0 || port > 65535) {
+    std::cerr << "IO." << name << ": port must be an Int in 0..65535"
+              << std::endl;
+    exit(1);
+  }
+  return (int)port;
+}
+
+static struct sockaddr_in loopback(int port) {
+  struct sockaddr_in addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  return addr;
+}
+
+static int tcp_socket() {
+  int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    exit_by_errno("socket");
+  }
+  return fd;
+}
+
+// IO.listen(port): a listening socket; port 0 picks a free one
+static Stream *io_listen(int64_t port_number) {
+  int port = port_arg("listen", port_number);
+  int fd = tcp_socket();
+  int one = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  struct sockaddr_in addr = loopback(port);
+  if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+    exit_by_errno("IO.listen");
+  }
+  if (listen(fd, SOMAXCONN) < 0) {
+    exit_by_errno("IO.listen");
+  }
+  return new Stream(fd, true);
+}
+
+// IO.connect(port): a Stream connected to the port
+static Value io_connect(int64_t port_number) {
+  int port = port_arg("connect", port_number);
+  int fd = tcp_socket();
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  auto *stream = new Stream(fd, true);
+  struct sockaddr_in addr = loopback(port);
+  if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+    return Value((Object *)stream);
+  }
+  if (errno != EINPROGRESS) {
+    exit_by_errno("IO.connect");
+  }
+  EventLoop::Wait wait;
+  wait.stream = stream;
+  wait.op = EventLoop::Op::CONNECT;
+  return perform(std::move(wait));
+}
+
+// IO.pipe(): [reader, writer]
+static Array *io_pipe() {
+  int fds[2];
+  if (pipe2(fds, O_NONBLOCK | O_CLOEXEC) < 0) {
+    exit_by_errno("IO.pipe");
+  }
+  std::vector<Value> ends = {Value((Object *)new Stream(fds[0], false)),
+                             Value((Object *)new Stream(fds[1], false))};
+  return new Array(std::move(ends));
+}
+
+// IO.run(): runs the tasks started by async { } until all of them finish
+static bool io_run() {
+  Isolate::current()->event_loop().run();
+  return true;
+}
+
+void IO::init() {
+  Klass::IO->set_method("listen", new Func(bind<&io_listen>()));
+  Klass::IO->set_method("connect", new Func(bind<&io_connect>()));
+  Klass::IO->set_method("pipe", new Func(bind<&io_pipe>()));
+  Klass::IO->set_method("run", new Func(bind<&io_run>()));
+
+  Klass::Stream->set_method("read", new Func(bind_method<&stream_read>()));
+  Klass::Stream->set_method("write", new Func(bind_method<&stream_write>()));
+  Klass::Stream->set_method("accept", new Func(bind_method<&stream_accept>()));
+  Klass::Stream->set_method("close", new Func(bind_method<&stream_close>()));
+  Klass::Stream->set_method("port", new Func(bind_method<&stream_port>()));
+}
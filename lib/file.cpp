@@ -0,0 +1,215 @@
+#include "holang/file.hpp"
+#include "holang.hpp"
+#include "holang/bind_builtins.hpp"
+#include "holang/isolate.hpp"
+#include "holang/string.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace holang;
+
+static const size_t WRITE_BUFFER_SIZE = 1 << 20;
+
+bool holang::load_file(const std::string &path,
+                       std::shared_ptr<const char> &data, size_t &size) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+    size = st.st_size;
+    if (size == 0) {
+      data.reset();
+      close(fd);
+      return true;
+    }
+    void *addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr != MAP_FAILED) {
+      close(fd);
+      madvise(addr, size, MADV_SEQUENTIAL);
+      size_t mapped_size = size;
+      data.reset(static_cast<const char *>(addr), [mapped_size](const char *p) {
+        munmap((void *)p, mapped_size);
+      });
+      return true;
+    }
+  }
+
+  // pipes, devices, or mmap failed: read it in blocks
+  std::string buf;
+  char block[1 << 16];
+  while (true) {
+    ssize_t n = read(fd, block, sizeof(block));
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      close(fd);
+      return false;
+    }
+    if (n == 0) {
+      break;
+    }
+    buf.append(block, n);
+  }
+  close(fd);
+  size = buf.size();
+  char *copy = new char[size];
+  std::memcpy(copy, buf.data(), size);
+  data.reset(copy, std::default_delete<char[]>());
+  return true;
+}
+
+static void exit_by_open_error(const std::string &path) {
+  std::cerr << path << ": " << strerror(errno) << std::endl;
+  exit(1);
+}
+
+// File.mmap(path): the whole file as a String sharing the mapping
+static String *file_mmap(const std::string &path) {
+  std::shared_ptr<const char> data;
+  size_t size;
+  if (!load_file(path, data, size)) {
+    exit_by_open_error(path);
+  }
+  return String::view(data, data.get(), size);
+}
+
+// File.read(path): the whole file as a String of its own
+static String *file_read(const std::string &path) {
+  std::shared_ptr<const char> data;
+  size_t size;
+  if (!load_file(path, data, size)) {
+    exit_by_open_error(path);
+  }
+  return new String(data.get(), size);
+}
+
+// File.each_line(path) { |line| }: lines without their terminators, as
+// views of the mapped file
+static bool file_each_line(const std::string &path, Func *block) {
+  std::shared_ptr<const char> data;
+  size_t size;
+  if (!load_file(path, data, size)) {
+    exit_by_open_error(path);
+  }
+
+  Value self(Klass::File);
+  const char *p = data.get();
+  const char *last = p + size;
+  while (p != last) {
+    auto *nl = static_cast<const char *>(memchr(p, '\n', last - p));
+    const char *end = nl == nullptr ? last : nl;
+    const char *content_end = end;
+    if (content_end != p && content_end[-1] == '\r') {
+      content_end--;
+    }
+    Value line((Object *)String::view(data, p, content_end - p));
+    call_func_argc_one(&self, block, &line);
+    p = nl == nullptr ? last : nl + 1;
+  }
+  return true;
+}
+
+// File.write(path, values...): replaces the file with the values
+static bool file_write(const std::string &path, Args values) {
+  int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    exit_by_open_error(path);
+  }
+  {
+    OutputBuffer out(fd, WRITE_BUFFER_SIZE);
+    for (Value &v : values) {
+      out.write(v);
+    }
+  }
+  close(fd);
+  return true;
+}
+
+// ----- FileWriter ----- //
+
+FileWriter::FileWriter(int fd)
+    : fd(fd), isolate(Isolate::current()),
+      out(new OutputBuffer(fd, WRITE_BUFFER_SIZE)) {
+  klass = Klass::FileWriter;
+  isolate->add_writer(this);
+}
+
+void FileWriter::close() {
+  if (out == nullptr) {
+    return;
+  }
+  out.reset();
+  ::close(fd);
+  isolate->remove_writer(this);
+}
+
+// File.create(path): a FileWriter truncating the file
+static FileWriter *file_create(const std::string &path) {
+  int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    exit_by_open_error(path);
+  }
+  return new FileWriter(fd);
+}
+
+static OutputBuffer *writer_buffer(FileWriter *writer) {
+  OutputBuffer *out = writer->get_buffer();
+  if (out == nullptr) {
+    std::cerr << "FileWriter: already closed" << std::endl;
+    exit(1);
+  }
+  return out;
+}
+
+static void writer_print(FileWriter *writer, Args values) {
+  OutputBuffer *out = writer_buffer(writer);
+  for (Value &v : values) {
+    out->write(v);
+  }
+}
+
+static void writer_println(FileWriter *writer, Args values) {
+  OutputBuffer *out = writer_buffer(writer);
+  for (int i = 0; i < values.size(); i++) {
+    if (i != 0) {
+      out->write(' ');
+    }
+    out->write(values[i]);
+  }
+  out->write('\n');
+}
+
+static void writer_flush(FileWriter *writer) {
+  writer_buffer(writer)->flush();
+}
+
+static bool writer_close(FileWriter *writer) {
+  writer->close();
+  return true;
+}
+
+void File::init() {
+  Klass::File->set_method("read", new Func(bind<&file_read>()));
+  Klass::File->set_method("mmap", new Func(bind<&file_mmap>()));
+  Klass::File->set_method("each_line", new Func(bind<&file_each_line>()));
+  Klass::File->set_method("write", new Func(bind<&file_write>()));
+  Klass::File->set_method("create", new Func(bind<&file_create>()));
+
+  Klass::FileWriter->set_method("print",
+                                new Func(bind_method<&writer_print>()));
+  Klass::FileWriter->set_method("println",
+                                new Func(bind_method<&writer_println>()));
+  Klass::FileWriter->set_method("flush",
+                                new Func(bind_method<&writer_flush>()));
+  Klass::FileWriter->set_method("close",
+                                new Func(bind_method<&writer_close>()));
+}
@@ -0,0 +1,352 @@
+#include "holang/hash.hpp"
+#include "holang.hpp"
+#include "holang/array.hpp"
+#include "holang/bind_builtins.hpp"
+#include "holang/output.hpp"
+#include "holang/string.hpp"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace holang;
+
+// ----- control bytes ----- //
+
+static const int8_t EMPTY = -128;  // 0b10000000
+static const int8_t DELETED = -2;  // 0b11111110
+static const size_t GROUP_WIDTH = 16;
+
+static uint64_t h1(uint64_t hash) { return hash >> 7; }
+static int8_t h2(uint64_t hash) { return hash & 0x7F; }
+
+namespace {
+// the control bytes of GROUP_WIDTH consecutive slots, matched as bitmasks
+struct Group {
+#ifdef __SSE2__
+  explicit Group(const int8_t *pos)
+      : ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i *>(pos))) {}
+
+  uint32_t match(int8_t h) const {
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h), ctrl));
+  }
+  uint32_t match_empty() const { return match(EMPTY); }
+  // EMPTY and DELETED are the only control bytes with the sign bit set
+  uint32_t match_empty_or_deleted() const { return _mm_movemask_epi8(ctrl); }
+
+  __m128i ctrl;
+#else
+  explicit Group(const int8_t *pos) : pos(pos) {}
+
+  uint32_t match(int8_t h) const {
+    uint32_t mask = 0;
+    for (size_t i = 0; i < GROUP_WIDTH; i++) {
+      mask |= uint32_t(pos[i] == h) << i;
+    }
+    return mask;
+  }
+  uint32_t match_empty() const { return match(EMPTY); }
+  uint32_t match_empty_or_deleted() const {
+    uint32_t mask = 0;
+    for (size_t i = 0; i < GROUP_WIDTH; i++) {
+      mask |= uint32_t(pos[i] < 0) << i;
+    }
+    return mask;
+  }
+
+  const int8_t *pos;
+#endif
+};
+
+// Visits the groups of a table of `capacity` slots in triangular order,
+// which reaches every group when the number of groups is a power of two.
+struct ProbeSeq {
+  ProbeSeq(uint64_t hash, size_t capacity)
+      : mask(capacity / GROUP_WIDTH - 1), group(h1(hash) & mask) {}
+
+  size_t offset() const { return group * GROUP_WIDTH; }
+  void next() {
+    stride++;
+    group = (group + stride) & mask;
+  }
+
+  size_t mask;
+  size_t group;
+  size_t stride = 0;
+};
+} // namespace
+
+static int lowest_bit(uint32_t mask) { return __builtin_ctz(mask); }
+
+// ----- keys ----- //
+
+// finalizer of MurmurHash3; spreads the bits of small ints to h1 and h2
+static uint64_t mix(uint64_t x) {
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+  return x;
+}
+
+static uint64_t hash_key(const Value &key) {
+  if (key.type == Type::INT) {
+    return mix(key.ival);
+  }
+  if (String::is_string(key)) {
+    return ((String *)key.objval)->hash();
+  }
+  Value v = key;
+  std::cerr << "Hash: key must be Int or String: " << v.to_s() << std::endl;
+  exit(1);
+}
+
+static bool key_equal(const Value &a, const Value &b) {
+  if (a.type == Type::INT) {
+    return b.type == Type::INT && a.ival == b.ival;
+  }
+  return String::is_string(b) &&
+         ((String *)a.objval)->equals(*(String *)b.objval);
+}
+
+// ----- table ----- //
+
+int64_t Hash::find_entry(const Value &key, uint64_t hash) const {
+  if (ctrl.empty()) {
+    return -1;
+  }
+  for (ProbeSeq seq(hash, ctrl.size());; seq.next()) {
+    Group g(&ctrl[seq.offset()]);
+    for (uint32_t m = g.match(h2(hash)); m != 0; m &= m - 1) {
+      uint32_t index = slots[seq.offset() + lowest_bit(m)];
+      const Entry &e = entries[index];
+      if (e.hash == hash && key_equal(e.key, key)) {
+        return index;
+      }
+    }
+    if (g.match_empty() != 0) {
+      return -1;
+    }
+  }
+}
+
+size_t Hash::find_insert_slot(uint64_t hash) const {
+  for (ProbeSeq seq(hash, ctrl.size());; seq.next()) {
+    uint32_t m = Group(&ctrl[seq.offset()]).match_empty_or_deleted();
+    if (m != 0) {
+      return seq.offset() + lowest_bit(m);
+    }
+  }
+}
+
+void Hash::set_ctrl(size_t slot, uint64_t hash, uint32_t entry) {
+  ctrl[slot] = h2(hash);
+  slots[slot] = entry;
+}
+
+// Rebuilds the index with `new_capacity` slots (a power of two, at least
+// GROUP_WIDTH) and drops the entries which were erased, unless pinned.
+void Hash::rehash(size_t new_capacity) {
+  if (count != entries.size() && pins == 0) {
+    size_t live = 0;
+    for (size_t i = 0; i < entries.size(); i++) {
+      if (entries[i].live) {
+        entries[live++] = entries[i];
+      }
+    }
+    entries.resize(live);
+  }
+
+  ctrl.assign(new_capacity, EMPTY);
+  slots.assign(new_capacity, 0);
+  for (size_t i = 0; i < entries.size(); i++) {
+    if (entries[i].live) {
+      set_ctrl(find_insert_slot(entries[i].hash), entries[i].hash, i);
+    }
+  }
+  // keep the load factor at most 7/8
+  growth_left = new_capacity - new_capacity / 8 - count;
+}
+
+Value *Hash::find(const Value &key) {
+  int64_t index = find_entry(key, hash_key(key));
+  return index < 0 ? nullptr : &entries[index].value;
+}
+
+void Hash::insert(const Value &key, const Value &value) {
+  uint64_t hash = hash_key(key);
+  int64_t index = find_entry(key, hash);
+  if (index >= 0) {
+    entries[index].value = value;
+    return;
+  }
+
+  // compact once erased entries outnumber the live ones, which keeps
+  // `entries` (and the positions in `slots`) bounded under churn
+  if (entries.size() >= 2 * count + GROUP_WIDTH && pins == 0) {
+    rehash(ctrl.size());
+  }
+
+  size_t slot = ctrl.empty() ? 0 : find_insert_slot(hash);
+  if (ctrl.empty() || (growth_left == 0 && ctrl[slot] == EMPTY)) {
+    // grow unless most of the used slots are DELETED
+    size_t capacity = std::max(ctrl.size(), GROUP_WIDTH);
+    if (count + 1 > (capacity - capacity / 8) / 2 || ctrl.empty()) {
+      capacity = ctrl.empty() ? GROUP_WIDTH : capacity * 2;
+    }
+    rehash(capacity);
+    slot = find_insert_slot(hash);
+  }
+
+  if (ctrl[slot] == EMPTY) {
+    growth_left--;
+  }
+  set_ctrl(slot, hash, entries.size());
+  entries.push_back(Entry{key, value, hash, true});
+  count++;
+}
+
+bool Hash::erase(const Value &key) {
+  uint64_t hash = hash_key(key);
+  int64_t index = find_entry(key, hash);
+  if (index < 0) {
+    return false;
+  }
+
+  for (ProbeSeq seq(hash, ctrl.size());; seq.next()) {
+    Group g(&ctrl[seq.offset()]);
+    for (uint32_t m = g.match(h2(hash)); m != 0; m &= m - 1) {
+      size_t slot = seq.offset() + lowest_bit(m);
+      if (slots[slot] == static_cast<uint64_t>(index)) {
+        ctrl[slot] = DELETED;
+        entries[index].live = false;
+        count--;
+        return true;
+      }
+    }
+  }
+}
+
+const std::string Hash::to_s() {
+  std::string str = "{";
+  bool first = true;
+  for (Entry &e : entries) {
+    if (!e.live) {
+      continue;
+    }
+    if (!first) {
+      str += ", ";
+    }
+    first = false;
+    str += e.key.to_s() + " => " + e.value.to_s();
+  }
+  return str + "}";
+}
+
+void Hash::write_to(OutputBuffer &out) {
+  out.write('{');
+  bool first = true;
+  for (Entry &e : entries) {
+    if (!e.live) {
+      continue;
+    }
+    if (!first) {
+      out.write(", ", 2);
+    }
+    first = false;
+    out.write(e.key);
+    out.write(" => ", 4);
+    out.write(e.value);
+  }
+  out.write('}');
+}
+
+// ----- methods ----- //
+
+static Hash *new_hash() { return new Hash(); }
+
+static Value hash_load(Hash *hash, Value key) {
+  Value *v = hash->find(key);
+  if (v == nullptr) {
+    std::cerr << "Hash#[]: key not found: " << key.to_s() << std::endl;
+    exit(1);
+  }
+  return *v;
+}
+
+static Value hash_store(Hash *hash, Value key, Value value) {
+  hash->insert(key, value);
+  return value;
+}
+
+// fetch(key, default)
+static Value hash_fetch(Hash *hash, Value key, std::optional<Value> fallback) {
+  Value *v = hash->find(key);
+  if (v != nullptr) {
+    return *v;
+  }
+  if (!fallback) {
+    return hash_load(hash, key);
+  }
+  return *fallback;
+}
+
+static bool hash_has_key(Hash *hash, Value key) {
+  return hash->find(key) != nullptr;
+}
+
+static bool hash_delete(Hash *hash, Value key) { return hash->erase(key); }
+
+static int64_t hash_size(Hash *hash) { return hash->size(); }
+
+static Array *hash_keys(Hash *hash) {
+  auto *keys = new Array();
+  for (const Hash::Entry &e : hash->get_entries()) {
+    if (e.live) {
+      keys->elements.push_back(e.key);
+    }
+  }
+  return keys;
+}
+
+static Array *hash_values(Hash *hash) {
+  auto *values = new Array();
+  for (const Hash::Entry &e : hash->get_entries()) {
+    if (e.live) {
+      values->elements.push_back(e.value);
+    }
+  }
+  return values;
+}
+
+// each() { |key, value| ... }
+static void hash_each(Hash *hash, Func *block) {
+  Value self((Object *)hash);
+  const auto &entries = hash->get_entries();
+  // The block may insert or delete: the pin keeps the positions, entries
+  // inserted by the block are not visited and deleted ones are skipped.
+  // Do not hold iterators since inserting may reallocate.
+  Hash::Pin pin(hash);
+  size_t end = entries.size();
+  for (size_t i = 0; i < end; i++) {
+    if (!entries[i].live) {
+      continue;
+    }
+    Value kv[2] = {entries[i].key, entries[i].value};
+    call_func_argc_two(&self, block, kv);
+  }
+}
+
+void Hash::init() {
+  Klass::Hash->methods["new"] = new Func(bind<&new_hash>());
+  Klass::Hash->set_method("[]", new Func(bind_method<&hash_load>()));
+  Klass::Hash->set_method("[]=", new Func(bind_method<&hash_store>()));
+  Klass::Hash->set_method("fetch", new Func(bind_method<&hash_fetch>()));
+  Klass::Hash->set_method("has_key", new Func(bind_method<&hash_has_key>()));
+  Klass::Hash->set_method("delete", new Func(bind_method<&hash_delete>()));
+  Klass::Hash->set_method("size", new Func(bind_method<&hash_size>()));
+  Klass::Hash->set_method("keys", new Func(bind_method<&hash_keys>()));
+  Klass::Hash->set_method("values", new Func(bind_method<&hash_values>()));
+  Klass::Hash->set_method("each", new Func(bind_method<&hash_each>()));
+}
@@ -0,0 +1,202 @@
+#include "holang/input.hpp"
+#include "holang/isolate.hpp"
+#include "holang/output.hpp"
+#include "holang/string.hpp"
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace holang;
+
+InputBuffer::InputBuffer(int fd, size_t capacity) : fd(fd), capacity(capacity) {
+  struct stat st;
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+    off_t offset = lseek(fd, 0, SEEK_CUR);
+    if (offset >= 0 && offset < st.st_size) {
+      void *addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (addr != MAP_FAILED) {
+        madvise(addr, st.st_size, MADV_SEQUENTIAL);
+        size_t size = st.st_size;
+        // strings read from the file keep the mapping alive
+        mapped.reset(static_cast<const char *>(addr),
+                     [size](const char *p) { munmap((void *)p, size); });
+        cur = static_cast<const char *>(addr) + offset;
+        end = static_cast<const char *>(addr) + st.st_size;
+        at_eof = true;
+        return;
+      }
+    }
+  }
+  buf = new char[capacity];
+  cur = end = buf;
+}
+
+InputBuffer::~InputBuffer() { delete[] buf; }
+
+String *InputBuffer::make_string(const char *first, const char *last) {
+  return String::view(mapped, first, last - first);
+}
+
+bool InputBuffer::fill(const char *&keep) {
+  if (at_eof) {
+    return false;
+  }
+
+  // a blocking read on a TTY: let a pending prompt be seen first
+  OutputBuffer &out = standard_output();
+  if (out.is_line_buffered()) {
+    out.flush();
+  }
+
+  size_t kept = end - keep;
+  if (kept == capacity) {
+    char *grown = new char[capacity * 2];
+    memcpy(grown, keep, kept);
+    delete[] buf;
+    buf = grown;
+    capacity *= 2;
+  } else if (kept != 0) {
+    memmove(buf, keep, kept);
+  }
+  keep = buf;
+  cur = buf + kept;
+  end = cur;
+
+  while (true) {
+    ssize_t n = ::read(fd, buf + kept, capacity - kept);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      cerr << "read error: " << strerror(errno) << endl;
+      exit(1);
+    }
+    if (n == 0) {
+      at_eof = true;
+      return false;
+    }
+    end = buf + kept + n;
+    return true;
+  }
+}
+
+bool InputBuffer::skip_space() {
+  while (true) {
+    int c = peek();
+    if (c < 0) {
+      return false;
+    }
+    if (!isspace(c)) {
+      return true;
+    }
+    cur++;
+  }
+}
+
+bool InputBuffer::eof() { return !skip_space(); }
+
+bool InputBuffer::read_int(int64_t &out) {
+  if (!skip_space()) {
+    return false;
+  }
+
+  bool negative = false;
+  if (*cur == '-' || *cur == '+') {
+    negative = *cur == '-';
+    cur++;
+  }
+  int c = peek();
+  if (c < '0' || '9' < c) {
+    cerr << "read_int: not an integer" << endl;
+    exit(1);
+  }
+
+  // the magnitude of INT64_MIN is one more than INT64_MAX
+  const uint64_t limit = static_cast<uint64_t>(INT64_MAX) + (negative ? 1 : 0);
+  uint64_t value = 0;
+  while (true) {
+    while (cur != end && static_cast<unsigned>(*cur - '0') < 10) {
+      unsigned digit = *cur - '0';
+      if (value > (limit - digit) / 10) {
+        cerr << "read_int: out of range of Int" << endl;
+        exit(1);
+      }
+      value = value * 10 + digit;
+      cur++;
+    }
+    if (cur != end || !fill()) {
+      break;
+    }
+  }
+  out = static_cast<int64_t>(negative ? 0 - value : value);
+  return true;
+}
+
+String *InputBuffer::read_word() {
+  if (!skip_space()) {
+    return new String("");
+  }
+
+  const char *first = cur;
+  const char *p = cur;
+  while (true) {
+    while (p != end && !isspace(static_cast<unsigned char>(*p))) {
+      p++;
+    }
+    if (p != end) {
+      break;
+    }
+    size_t scanned = p - first;
+    if (!fill(first)) {
+      p = end;
+      break;
+    }
+    p = first + scanned;
+  }
+  cur = p;
+  return make_string(first, p);
+}
+
+String *InputBuffer::read_line() {
+  if (peek() < 0) {
+    return new String("");
+  }
+
+  const char *first = cur;
+  const char *p = cur;
+  while (true) {
+    const char *nl =
+        static_cast<const char *>(memchr(p, '\n', end - p));
+    if (nl != nullptr) {
+      p = nl;
+      break;
+    }
+    size_t scanned = end - first;
+    if (!fill(first)) {
+      p = end;
+      break;
+    }
+    p = first + scanned;
+  }
+
+  const char *last = p;
+  cur = p == end ? end : p + 1;
+  if (last != first && last[-1] == '\r') {
+    last--;
+  }
+  return make_string(first, last);
+}
+
+InputBuffer &holang::standard_input() {
+  Isolate *isolate = Isolate::current();
+  if (isolate != nullptr) {
+    return isolate->input();
+  }
+  static InputBuffer in(STDIN_FILENO);
+  return in;
+}
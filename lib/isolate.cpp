@@ -0,0 +1,126 @@
+#include "holang/isolate.hpp"
+#include "config.hpp"
+#include "holang/event_loop.hpp"
+#include "holang/file.hpp"
+#include "holang/scheduler.hpp"
+#include <cstdlib>
+#include <mutex>
+
+using namespace holang;
+
+thread_local Isolate *Isolate::entered = nullptr;
+
+// isolates alive in the process, flushed when it exits
+static std::mutex live_mutex;
+
+static std::set<Isolate *> &live_isolates() {
+  static std::set<Isolate *> isolates;
+  return isolates;
+}
+
+static void flush_at_exit() {
+  std::lock_guard<std::mutex> lock(live_mutex);
+  for (Isolate *isolate : live_isolates()) {
+    isolate->flush();
+  }
+}
+
+Isolate::Isolate(int in_fd, int out_fd) : in_fd(in_fd), out(out_fd) {
+#ifdef PATH_HOLIB
+  import_search_path.push_back(PATH_HOLIB);
+#else
+  import_search_path.push_back("/");
+#endif
+
+  {
+    std::lock_guard<std::mutex> lock(live_mutex);
+    live_isolates().insert(this);
+  }
+  // registered after the set is constructed so that it runs before the set
+  // is destroyed
+  static std::once_flag registered;
+  std::call_once(registered, [] { atexit(flush_at_exit); });
+}
+
+Isolate::~Isolate() {
+  // let the spawned tasks finish while everything is still alive
+  workers.reset();
+  {
+    std::lock_guard<std::mutex> lock(live_mutex);
+    live_isolates().erase(this);
+  }
+  flush();
+}
+
+InputBuffer &Isolate::input() {
+  std::call_once(in_created, [this] { in.reset(new InputBuffer(in_fd)); });
+  return *in;
+}
+
+Scheduler &Isolate::scheduler() {
+  if (workers == nullptr) {
+    // one worker per CPU unless HOLANG_WORKERS says otherwise
+    unsigned count = std::thread::hardware_concurrency();
+    const char *env = getenv("HOLANG_WORKERS");
+    if (env != nullptr && atoi(env) > 0) {
+      count = atoi(env);
+    }
+    threaded = true;
+    workers.reset(new Scheduler(this, count));
+  }
+  return *workers;
+}
+
+EventLoop &Isolate::event_loop() {
+  if (loop == nullptr) {
+    loop.reset(new EventLoop());
+  }
+  return *loop;
+}
+
+void Isolate::add_writer(FileWriter *writer) {
+  std::lock_guard<std::mutex> lock(writers_mutex);
+  open_writers.insert(writer);
+}
+
+void Isolate::remove_writer(FileWriter *writer) {
+  std::lock_guard<std::mutex> lock(writers_mutex);
+  open_writers.erase(writer);
+}
+
+void Isolate::flush() {
+  std::set<FileWriter *> writers;
+  {
+    // copied: close() removes the writer
+    std::lock_guard<std::mutex> lock(writers_mutex);
+    writers = open_writers;
+  }
+  for (FileWriter *writer : writers) {
+    writer->close();
+  }
+  out.flush();
+}
+
+void Isolate::enter(Isolate *isolate) {
+  entered = isolate;
+  Klass::Int = isolate ? &isolate->int_klass : nullptr;
+  Klass::Double = isolate ? &isolate->double_klass : nullptr;
+  Klass::BigInt = isolate ? &isolate->bigint_klass : nullptr;
+  Klass::String = isolate ? &isolate->string_klass : nullptr;
+  Klass::Array = isolate ? &isolate->array_klass : nullptr;
+  Klass::Hash = isolate ? &isolate->hash_klass : nullptr;
+  Klass::StringBuilder = isolate ? &isolate->string_builder_klass : nullptr;
+  Klass::Range = isolate ? &isolate->range_klass : nullptr;
+  Klass::Lazy = isolate ? &isolate->lazy_klass : nullptr;
+  Klass::File = isolate ? &isolate->file_klass : nullptr;
+  Klass::FileWriter = isolate ? &isolate->file_writer_klass : nullptr;
+  Klass::Future = isolate ? &isolate->future_klass : nullptr;
+  Klass::Coroutine = isolate ? &isolate->coroutine_klass : nullptr;
+  Klass::IO = isolate ? &isolate->io_klass : nullptr;
+  Klass::Stream = isolate ? &isolate->stream_klass : nullptr;
+  Klass::Channel = isolate ? &isolate->channel_klass : nullptr;
+}
+
+Isolate::Scope::Scope(Isolate *isolate) : outer(entered) { enter(isolate); }
+
+Isolate::Scope::~Scope() { enter(outer); }
@@ -0,0 +1,178 @@
+#include "holang/lazy.hpp"
+#include "holang.hpp"
+#include "holang/arith.hpp"
+#include "holang/array.hpp"
+#include "holang/bind_builtins.hpp"
+#include "holang/coroutine.hpp"
+#include "holang/range.hpp"
+
+using namespace holang;
+
+static bool truthy(const Value &v) { return v.type != Type::BOOL || v.bval; }
+
+template <typename Sink> void Lazy::run(Sink sink) {
+  // remaining counts of the TAKE stages for this run
+  std::vector<int64_t> remaining(steps.size());
+  for (size_t i = 0; i < steps.size(); i++) {
+    if (steps[i].stage == Stage::TAKE && steps[i].count <= 0) {
+      return;
+    }
+    remaining[i] = steps[i].count;
+  }
+
+  Value src = source;
+  bool done = false;
+  // runs one source element through the stages; false stops the loop
+  auto feed = [&](Value v) {
+    for (size_t i = 0; i < steps.size(); i++) {
+      const Step &step = steps[i];
+      switch (step.stage) {
+      case Stage::MAP:
+        v = call_func_argc_one(&src, step.func, &v);
+        break;
+      case Stage::FILTER:
+        if (!truthy(call_func_argc_one(&src, step.func, &v))) {
+          return true;
+        }
+        break;
+      case Stage::REJECT:
+        if (truthy(call_func_argc_one(&src, step.func, &v))) {
+          return true;
+        }
+        break;
+      case Stage::TAKE:
+        // stop before the next element is pulled from the source
+        if (--remaining[i] == 0) {
+          done = true;
+        }
+        break;
+      case Stage::TAKE_WHILE:
+        if (!truthy(call_func_argc_one(&src, step.func, &v))) {
+          return false;
+        }
+        break;
+      }
+    }
+    return sink(v) && !done;
+  };
+
+  if (Array::is_array(src)) {
+    auto &elements = ((Array *)src.objval)->elements;
+    // a block may push to the array, so do not hold iterators
+    for (size_t i = 0; i < elements.size(); i++) {
+      if (!feed(elements[i])) {
+        return;
+      }
+    }
+  } else if (Coroutine::is_coroutine(src)) {
+    auto *co = (Coroutine *)src.objval;
+    Value v;
+    while (!co->is_done() && co->resume(nullptr, 0, v)) {
+      if (!feed(v)) {
+        return;
+      }
+    }
+  } else {
+    auto *range = (Range *)src.objval;
+    for (int64_t i = range->first; i <= range->last; i++) {
+      if (!feed(Value(i)) || i == range->last) {
+        return;
+      }
+    }
+  }
+}
+
+static Lazy *add_step(Lazy *lazy, Lazy::Stage stage, Func *func,
+                      int64_t count) {
+  auto *extended = new Lazy(lazy->source);
+  extended->steps = lazy->steps;
+  extended->steps.push_back({stage, func, count});
+  return extended;
+}
+
+static Lazy *lazy_map(Lazy *lazy, Func *block) {
+  return add_step(lazy, Lazy::Stage::MAP, block, 0);
+}
+
+static Lazy *lazy_filter(Lazy *lazy, Func *block) {
+  return add_step(lazy, Lazy::Stage::FILTER, block, 0);
+}
+
+static Lazy *lazy_reject(Lazy *lazy, Func *block) {
+  return add_step(lazy, Lazy::Stage::REJECT, block, 0);
+}
+
+static Lazy *lazy_take_while(Lazy *lazy, Func *block) {
+  return add_step(lazy, Lazy::Stage::TAKE_WHILE, block, 0);
+}
+
+static Lazy *lazy_take(Lazy *lazy, int64_t count) {
+  return add_step(lazy, Lazy::Stage::TAKE, nullptr, count);
+}
+
+static void lazy_each(Lazy *lazy, Func *block) {
+  Value self((Object *)lazy);
+  lazy->run([&](Value v) {
+    call_func_argc_one(&self, block, &v);
+    return true;
+  });
+}
+
+static Array *lazy_to_a(Lazy *lazy) {
+  auto *array = new Array();
+  lazy->run([&](Value v) {
+    array->elements.push_back(v);
+    return true;
+  });
+  return array;
+}
+
+static Value lazy_sum(Lazy *lazy) {
+  Value total((int64_t)0);
+  lazy->run([&](Value v) {
+    int64_t r;
+    if (total.type == Type::INT && v.type == Type::INT &&
+        !__builtin_add_overflow(total.ival, v.ival, &r)) {
+      total.ival = r;
+    } else {
+      total = binop_generic(Instruction::ADD, total, v);
+    }
+    return true;
+  });
+  return total;
+}
+
+// first() is the first element, or false when there is none;
+// first(n) is an Array of at most n elements
+static Value lazy_first(Lazy *lazy, std::optional<int64_t> count) {
+  if (count) {
+    Lazy *taken = add_step(lazy, Lazy::Stage::TAKE, nullptr, *count);
+    return Value((Object *)lazy_to_a(taken));
+  }
+  Value first(false);
+  lazy->run([&](Value v) {
+    first = v;
+    return false;
+  });
+  return first;
+}
+
+// Array#lazy, Range#lazy and Coroutine#lazy
+static Lazy *new_lazy(Value source) { return new Lazy(source); }
+
+void Lazy::init() {
+  Klass::Lazy->set_method("map", new Func(bind_method<&lazy_map>()));
+  Klass::Lazy->set_method("filter", new Func(bind_method<&lazy_filter>()));
+  Klass::Lazy->set_method("reject", new Func(bind_method<&lazy_reject>()));
+  Klass::Lazy->set_method("take", new Func(bind_method<&lazy_take>()));
+  Klass::Lazy->set_method("take_while",
+                          new Func(bind_method<&lazy_take_while>()));
+  Klass::Lazy->set_method("each", new Func(bind_method<&lazy_each>()));
+  Klass::Lazy->set_method("to_a", new Func(bind_method<&lazy_to_a>()));
+  Klass::Lazy->set_method("sum", new Func(bind_method<&lazy_sum>()));
+  Klass::Lazy->set_method("first", new Func(bind_method<&lazy_first>()));
+
+  Klass::Array->set_method("lazy", new Func(bind_method<&new_lazy>()));
+  Klass::Range->set_method("lazy", new Func(bind_method<&new_lazy>()));
+  Klass::Coroutine->set_method("lazy", new Func(bind_method<&new_lazy>()));
+}
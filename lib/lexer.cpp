@@ -1,4 +1,5 @@
 #include "holang/lexer.hpp"
+#include "holang/number.hpp"
 #include <iostream>
 #include <map>
 #include <string>
@@ -7,26 +8,20 @@
 using namespace std;
 using namespace holang;
 
-map<string, TokenType> Lexer::keywords;
-
-void Lexer::init_keywords() {
-  if (!Lexer::keywords.empty()) {
-    return;
-  }
-
-  keywords["true"] = TokenType::True;
-  keywords["false"] = TokenType::False;
-  keywords["if"] = TokenType::If;
-  keywords["else"] = TokenType::Else;
-  keywords["func"] = TokenType::Func;
-  keywords["class"] = TokenType::Class;
-  keywords["import"] = TokenType::Import;
-  keywords["while"] = TokenType::While;
-  keywords["return"] = TokenType::Return;
+const map<string, TokenType> &Lexer::keywords() {
+  static const map<string, TokenType> table = {
+      {"true", TokenType::True},     {"false", TokenType::False},
+      {"if", TokenType::If},         {"else", TokenType::Else},
+      {"func", TokenType::Func},     {"class", TokenType::Class},
+      {"import", TokenType::Import}, {"while", TokenType::While},
+      {"return", TokenType::Return}, {"for", TokenType::For},
+      {"in", TokenType::In},         {"yield", TokenType::Yield},
+  };
+  return table;
 }
 
 bool Lexer::is_next(char c) {
-  if (code_str[head] == c) {
+  if (nextc() == c) {
     head++;
     return true;
   } else {
@@ -34,26 +29,35 @@ bool Lexer::is_next(char c) {
   }
 }
 
-char Lexer::nextc() const { return code_str[head]; }
+// '\0' past the end of the code
+char Lexer::nextc() const { return head < code_size ? code[head] : '\0'; }
 
-char Lexer::readc() { return code_str[head++]; }
+char Lexer::readc() {
+  char c = nextc();
+  head++;
+  return c;
+}
 
 void Lexer::unreadc() { head--; }
 
-Token *make_integer(const string &sval) {
-  uint64_t i = stoi(sval);
-  return new Token(i);
+Token *make_integer(const char *first, const char *last) {
+  int64_t i;
+  if (parse_int(first, last, i) != last) {
+    return nullptr;
+  }
+  return new Token((uint64_t)i);
 }
 
-Token *make_double(const string &sval) {
-  double d = stod(sval);
+Token *make_double(const char *first, const char *last) {
+  double d;
+  parse_double(first, last, d);
   return new Token(d);
 }
 
 Token *make_token(TokenType type) { return new Token(type); }
 
 Token *Lexer::read_number(char c) {
-  string sval(1, c);
+  size_t begin = head - 1;
   bool has_dot = false;
   while (true) {
     char c = readc();
@@ -64,27 +68,30 @@ Token *Lexer::read_number(char c) {
       }
       char nc = readc();
       if (isdigit(nc)) {
-        sval.push_back('.');
-        sval.push_back(nc);
         has_dot = true;
       } else {
         unreadc();
         unreadc();
         break;
       }
-    } else if (isdigit(c)) {
-      sval.push_back(c);
-    } else {
+    } else if (!isdigit(c)) {
       unreadc();
       break;
     }
   }
 
+  const char *first = code + begin;
+  const char *last = code + head;
   if (has_dot) {
-    return make_double(sval);
-  } else {
-    return make_integer(sval);
+    return make_double(first, last);
   }
+  Token *token = make_integer(first, last);
+  if (token == nullptr) {
+    cerr << "integer literal is too large";
+    cerr << " at line " << line << ", col " << begin - line_begin_at << endl;
+    exit(1);
+  }
+  return token;
 }
 
 Token *make_ident(const string &ident) {
@@ -97,8 +104,8 @@ Token *Lexer::read_ident(char c) {
     char c = readc();
     if (!(isalnum(c) || c == '_')) {
       unreadc();
-      auto k = keywords.find(sval);
-      if (k != keywords.end())
+      auto k = keywords().find(sval);
+      if (k != keywords().end())
         return make_token(k->second);
       else
         return make_ident(sval);
@@ -109,15 +116,29 @@ Token *Lexer::read_ident(char c) {
 
 Token *make_str(const string &str) { return new Token(TokenType::String, str); }
 
-Token *Lexer::read_str() {
+// A string containing "#{expr}" is lexed as StringBegin, the tokens of
+// expr, then StringMid for each further interpolation and StringEnd.
+Token *Lexer::read_str(bool continued) {
   string str = "";
   while (true) {
     char c = readc();
     if (c == '"') {
       break;
     }
+    if (c == '\0' && head > code_size) {
+      cerr << "unterminated string at line " << line << endl;
+      exit(1);
+    }
+    if (c == '#' && is_next('{')) {
+      interpolations.push_back(0);
+      return new Token(continued ? TokenType::StringMid : TokenType::StringBegin,
+                       str);
+    }
     str.push_back(c);
   }
+  if (continued) {
+    return new Token(TokenType::StringEnd, str);
+  }
   return make_str(str);
 }
 
@@ -142,7 +163,15 @@ void Lexer::skip_blank() {
 }
 
 void Lexer::skip_to_newline() {
-  while (readc() != '\n') {
+  while (true) {
+    char c = readc();
+    if (c == '\n') {
+      break;
+    }
+    if (c == '\0' && head > code_size) {
+      unreadc();
+      return;
+    }
   }
   line++;
   line_begin_at = head;
@@ -237,8 +266,18 @@ Token *Lexer::take_token() {
   case ')':
     return make_token(TokenType::ParenR);
   case '{':
+    if (!interpolations.empty()) {
+      interpolations.back()++;
+    }
     return make_token(TokenType::BraseL);
   case '}':
+    if (!interpolations.empty()) {
+      if (interpolations.back() == 0) {
+        interpolations.pop_back();
+        return read_str(true);
+      }
+      interpolations.back()--;
+    }
     return make_token(TokenType::BraseR);
   case '[':
     return make_token(TokenType::BracketL);
@@ -247,7 +286,11 @@ Token *Lexer::take_token() {
   case ',':
     return make_token(TokenType::Comma);
   case '.':
-    return make_token(TokenType::Dot);
+    if (is_next('.')) {
+      return make_token(TokenType::DotDot);
+    } else {
+      return make_token(TokenType::Dot);
+    }
   case '|':
     if (is_next('|')) {
       return make_token(TokenType::OR);
@@ -285,7 +328,7 @@ void Lexer::lex(vector<Token *> &token_chain) {
   line = 1;
   head = 0;
 
-  while (head <= code_str.size()) {
+  while (head <= code_size) {
     Token *token = take_token();
     token->line = line;
     token->column = token_begin_at - line_begin_at + 1;
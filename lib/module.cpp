@@ -0,0 +1,436 @@
+#include "holang/module.hpp"
+#include "config.hpp"
+#include "holang.hpp"
+#include "holang/file.hpp"
+#include "holang/lexer.hpp"
+#include "holang/parser.hpp"
+#include "holang/trace.hpp"
+#include "holang/verifier.hpp"
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sys/stat.h>
+
+using namespace holang;
+
+// ----- snapshot format ----- //
+//
+// All numbers are little-endian as on the machine which wrote it; a
+// snapshot is a cache for one build, not an exchange format.
+//
+//   magic "HOSNAP\0\0", u32 version, u32 INSTRUCTION_SIZE,
+//   u64 source size, i64 source mtime (ns),
+//   u32 string count, strings (u32 length, bytes),
+//   u32 local size, code
+//
+// where code is u32 byte count and the bytes of the CodeSequence, then
+// u32 constant count and its constant table: ints are i64, doubles 8
+// bytes, strings an u32 index into the string table and funcs u32 local
+// size, u8 generator, u32 capture count, the captures (two u32 slots each)
+// and the code of their body. What a constant is comes from the
+// instruction referring to it.
+
+static const char MAGIC[8] = {'H', 'O', 'S', 'N', 'A', 'P', 0, 0};
+static const uint32_t VERSION = 4;
+
+enum class Constant { UNUSED, INT, DOUBLE, STRING, FUNC };
+
+// the kinds of the `count` constants referred to by the instructions in
+// `bytes`, or false if they do not decode
+static bool constant_kinds(const std::vector<uint8_t> &bytes, size_t count,
+                           std::vector<Constant> &kinds) {
+  kinds.assign(count, Constant::UNUSED);
+  for (size_t pc = 0; pc < bytes.size();) {
+    if (bytes[pc] >= INSTRUCTION_SIZE) {
+      return false;
+    }
+    auto op = static_cast<Instruction>(bytes[pc]);
+    if (pc + encoded_size(op) > bytes.size()) {
+      return false;
+    }
+    for (int i = 0; i < operand_count(op); i++) {
+      if (!is_constant_operand(op, i)) {
+        continue;
+      }
+      uint32_t index;
+      std::memcpy(&index, &bytes[pc + 1 + i * CodeSequence::OPERAND_SIZE],
+                  sizeof(index));
+      Constant kind = Constant::STRING;
+      if (op == Instruction::PUT_INT) {
+        kind = Constant::INT;
+      } else if (op == Instruction::PUT_DOUBLE) {
+        kind = Constant::DOUBLE;
+      } else if (op == Instruction::PUT_LAMBDA ||
+                 op == Instruction::MAKE_CLOSURE ||
+                 (op == Instruction::DEF_FUNC && i == 1)) {
+        kind = Constant::FUNC;
+      }
+      if (index >= count ||
+          (kinds[index] != Constant::UNUSED && kinds[index] != kind)) {
+        return false;
+      }
+      kinds[index] = kind;
+    }
+    pc += encoded_size(op);
+  }
+  return true;
+}
+
+namespace {
+class SnapshotWriter {
+public:
+  void u8(uint8_t v) { body.push_back(static_cast<char>(v)); }
+  void u32(uint32_t v) { raw(body, &v, sizeof(v)); }
+  void i64(int64_t v) { raw(body, &v, sizeof(v)); }
+
+  void code(const CodeSequence &codes) {
+    const std::vector<uint8_t> &bytes = codes.get_bytes();
+    const std::vector<Code> &constants = codes.get_constants();
+    u32(bytes.size());
+    raw(body, bytes.data(), bytes.size());
+    u32(constants.size());
+    std::vector<Constant> kinds;
+    constant_kinds(bytes, constants.size(), kinds);
+    for (size_t i = 0; i < constants.size(); i++) {
+      const Code &constant = constants[i];
+      switch (kinds[i]) {
+      case Constant::UNUSED:
+      case Constant::INT:
+        i64(constant.ival);
+        break;
+      case Constant::DOUBLE:
+        raw(body, &constant.dval, sizeof(constant.dval));
+        break;
+      case Constant::STRING:
+        u32(intern(*constant.sval));
+        break;
+      case Constant::FUNC:
+        u32(constant.funcval->local_size);
+        u8(constant.funcval->generator);
+        u32(constant.funcval->captures.size());
+        for (auto &capture : constant.funcval->captures) {
+          u32(capture.first);
+          u32(capture.second);
+        }
+        code(constant.funcval->body);
+        break;
+      }
+    }
+  }
+
+  std::string finish(const SourceStamp &stamp, int local_size) {
+    std::string out(MAGIC, sizeof(MAGIC));
+    uint32_t header[] = {VERSION, static_cast<uint32_t>(INSTRUCTION_SIZE)};
+    raw(out, header, sizeof(header));
+    raw(out, &stamp.size, sizeof(stamp.size));
+    raw(out, &stamp.mtime_ns, sizeof(stamp.mtime_ns));
+    uint32_t count = strings.size();
+    raw(out, &count, sizeof(count));
+    for (const std::string *str : strings) {
+      uint32_t length = str->size();
+      raw(out, &length, sizeof(length));
+      out += *str;
+    }
+    uint32_t locals = local_size;
+    raw(out, &locals, sizeof(locals));
+    return out + body;
+  }
+
+private:
+  static void raw(std::string &out, const void *p, size_t size) {
+    out.append(static_cast<const char *>(p), size);
+  }
+
+  uint32_t intern(const std::string &str) {
+    auto it = index.find(str);
+    if (it != index.end()) {
+      return it->second;
+    }
+    uint32_t i = strings.size();
+    it = index.emplace(str, i).first;
+    strings.push_back(&it->first);
+    return i;
+  }
+
+  std::string body;
+  std::map<std::string, uint32_t> index;
+  std::vector<const std::string *> strings;
+};
+
+class SnapshotReader {
+public:
+  SnapshotReader(const char *data, size_t size) : p(data), end(data + size) {}
+
+  template <typename T> bool read(T &v) {
+    if (left() < sizeof(T)) {
+      return false;
+    }
+    std::memcpy(&v, p, sizeof(T));
+    p += sizeof(T);
+    return true;
+  }
+
+  bool header(const SourceStamp &stamp) {
+    char magic[sizeof(MAGIC)];
+    uint32_t version, instruction_size;
+    SourceStamp recorded;
+    if (!read(magic) || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 ||
+        !read(version) || version != VERSION || !read(instruction_size) ||
+        instruction_size != INSTRUCTION_SIZE || !read(recorded.size) ||
+        !read(recorded.mtime_ns) || !(recorded == stamp)) {
+      return false;
+    }
+    // a string takes its length at least
+    uint32_t count;
+    if (!read(count) || count > left() / sizeof(uint32_t)) {
+      return false;
+    }
+    // every distinct name or literal is allocated once
+    strings.reserve(count);
+    for (uint32_t i = 0; i < count; i++) {
+      uint32_t length;
+      if (!read(length) || left() < length) {
+        return false;
+      }
+      strings.push_back(new std::string(p, length));
+      p += length;
+    }
+    return true;
+  }
+
+  bool code(CodeSequence &codes) {
+    uint32_t size;
+    if (!read(size) || left() < size) {
+      return false;
+    }
+    std::vector<uint8_t> bytes(p, p + size);
+    p += size;
+    uint32_t count;
+    std::vector<Constant> kinds;
+    if (!read(count) || count > left() / sizeof(uint32_t) ||
+        !constant_kinds(bytes, count, kinds)) {
+      return false;
+    }
+    std::vector<Code> constants(count);
+    for (uint32_t i = 0; i < count; i++) {
+      if (!constant(kinds[i], codes.source_path, constants[i])) {
+        return false;
+      }
+    }
+    codes.assign(std::move(bytes), std::move(constants));
+    return true;
+  }
+
+  bool at_end() const { return p == end; }
+
+private:
+  size_t left() const { return static_cast<size_t>(end - p); }
+
+  bool constant(Constant kind, const std::string &source_path, Code &out) {
+    switch (kind) {
+    case Constant::UNUSED:
+    case Constant::INT:
+      return read(out.ival);
+    case Constant::DOUBLE:
+      return read(out.dval);
+    case Constant::STRING: {
+      uint32_t i;
+      if (!read(i) || i >= strings.size()) {
+        return false;
+      }
+      out.sval = strings[i];
+      return true;
+    }
+    case Constant::FUNC: {
+      uint32_t local_size;
+      uint8_t generator;
+      uint32_t capture_count;
+      if (!read(local_size) || !read(generator) || !read(capture_count) ||
+          capture_count > left() / 8) {
+        return false;
+      }
+      auto *func = new Func(CodeSequence(source_path), local_size);
+      for (uint32_t i = 0; i < capture_count; i++) {
+        uint32_t from, to;
+        read(from);
+        read(to);
+        func->captures.emplace_back(from, to);
+      }
+      if (!code(func->body)) {
+        delete func;
+        return false;
+      }
+      func->generator = generator != 0;
+      out.funcval = func;
+      return true;
+    }
+    }
+    return false;
+  }
+
+  const char *p;
+  const char *end;
+  std::vector<std::string *> strings;
+};
+} // namespace
+
+// ----- Module ----- //
+
+bool SourceStamp::of(const std::string &path, SourceStamp &out) {
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0) {
+    return false;
+  }
+  out.size = st.st_size;
+  out.mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 +
+                 st.st_mtim.tv_nsec;
+  return true;
+}
+
+std::string Module::snapshot(const SourceStamp &stamp) const {
+  SnapshotWriter writer;
+  writer.code(codes);
+  return writer.finish(stamp, local_size);
+}
+
+Module *Module::from_snapshot(const char *data, size_t size,
+                              const std::string &path,
+                              const SourceStamp &stamp) {
+  SnapshotReader reader(data, size);
+  uint32_t local_size;
+  if (!reader.header(stamp) || !reader.read(local_size)) {
+    return nullptr;
+  }
+  std::unique_ptr<Module> module(new Module(path));
+  module->local_size = local_size;
+  std::string error;
+  if (!reader.code(module->codes) || !reader.at_end() ||
+      !Verifier::verify_all(module->codes, module->local_size, error)) {
+    return nullptr;
+  }
+  return module.release();
+}
+
+Module *Module::compile(const char *source, size_t size,
+                        const std::string &path) {
+  std::vector<Token *> token_chain;
+  {
+    Trace::Scope scope("lex " + path, "compile");
+    Lexer lexer(source, size);
+    lexer.lex(token_chain);
+  }
+
+  Parser parser(token_chain);
+  Node *root;
+  {
+    Trace::Scope scope("parse " + path, "compile");
+    root = parser.parse();
+  }
+  auto *module = new Module(path);
+  module->local_size = parser.toplevel_val_size();
+  {
+    Trace::Scope scope("codegen " + path, "compile");
+    if (root != nullptr) {
+      root->code_gen(&module->codes);
+    }
+    module->codes.append(Instruction::RET);
+  }
+  std::string error;
+  if (!Verifier::verify_all(module->codes, module->local_size, error)) {
+    std::cerr << path << ": invalid code: " << error << std::endl;
+    exit(1);
+  }
+  return module;
+}
+
+static bool exists(const std::string &path) {
+  struct stat st;
+  return stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode);
+}
+
+std::string Module::resolve(const std::string &name,
+                            const std::vector<std::string> &search_path) {
+  std::vector<std::string> candidates;
+  if (name.empty() || name.front() != '.') {
+    for (const auto &prefix : search_path) {
+      candidates.push_back(prefix + '/' + name);
+    }
+  }
+  candidates.push_back(name);
+  for (const auto &candidate : candidates) {
+    if (exists(candidate)) {
+      return candidate;
+    }
+    if (exists(candidate + ".ho")) {
+      return candidate + ".ho";
+    }
+  }
+  return name;
+}
+
+// where a snapshot of the source at `path` may be
+static std::vector<std::string> snapshot_paths(const std::string &path) {
+  std::vector<std::string> paths = {path + 'c'};
+#ifdef PATH_HOLIB_SNAPSHOT
+  std::string holib = PATH_HOLIB;
+  holib += '/';
+  if (path.compare(0, holib.size(), holib) == 0) {
+    paths.push_back(std::string(PATH_HOLIB_SNAPSHOT) + '/' +
+                    path.substr(holib.size()) + 'c');
+  }
+#endif
+  return paths;
+}
+
+static Module *load_snapshot(const std::string &path,
+                             const SourceStamp &stamp) {
+  for (const auto &snapshot : snapshot_paths(path)) {
+    std::shared_ptr<const char> data;
+    size_t size;
+    if (!exists(snapshot) || !load_file(snapshot, data, size)) {
+      continue;
+    }
+    Trace::Scope scope("snapshot " + snapshot, "compile");
+    Module *module = Module::from_snapshot(data.get(), size, path, stamp);
+    if (module != nullptr) {
+      return module;
+    }
+  }
+  return nullptr;
+}
+
+const Module *Module::load(const std::string &path) {
+  // modules compiled by any isolate, with the stamp of their source
+  static std::mutex mutex;
+  static std::map<std::string, std::pair<SourceStamp, Module *>> modules;
+
+  SourceStamp stamp;
+  if (!SourceStamp::of(path, stamp)) {
+    std::cerr << path << ": Not found." << std::endl;
+    exit(1);
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = modules.find(path);
+    if (it != modules.end() && it->second.first == stamp) {
+      return it->second.second;
+    }
+  }
+
+  Module *module = load_snapshot(path, stamp);
+  if (module == nullptr) {
+    std::shared_ptr<const char> source;
+    size_t size;
+    if (!load_file(path, source, size)) {
+      std::cerr << path << ": Not found." << std::endl;
+      exit(1);
+    }
+    module = compile(source.get(), size, path);
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+  modules[path] = {stamp, module};
+  return module;
+}
@@ -0,0 +1,20 @@
+#include "holang/node.hpp"
+
+using namespace std;
+using namespace holang;
+
+void ArrayLiteralNode::print(int offset) {
+  print_offset(offset);
+  cout << "ArrayLiteral" << endl;
+  for (Node *element : elements) {
+    element->print(offset + 1);
+  }
+}
+
+void ArrayLiteralNode::code_gen(CodeSequence *codes) {
+  for (Node *element : elements) {
+    element->code_gen(codes);
+  }
+  codes->append(Instruction::NEW_ARRAY);
+  codes->append((int)elements.size());
+}
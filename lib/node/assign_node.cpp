@@ -11,6 +11,7 @@ void AssignNode::print(int offset) {
 
 void AssignNode::code_gen(CodeSequence *codes) {
   rhs->code_gen(codes);
-  codes->append(Instruction::STORE_LOCAL);
+  codes->append(lhs->var->captured ? Instruction::STORE_CELL
+                                   : Instruction::STORE_LOCAL);
   codes->append(lhs->index);
 }
@@ -0,0 +1,13 @@
+#include "holang/node.hpp"
+
+using namespace holang;
+
+void DoubleLiteralNode::print(int offset) {
+  print_offset(offset);
+  cout << "DoubleLiteral " << value << "" << endl;
+}
+
+void DoubleLiteralNode::code_gen(CodeSequence *codes) {
+  codes->append(Instruction::PUT_DOUBLE);
+  codes->append(value);
+}
@@ -0,0 +1,62 @@
+#include "holang/node.hpp"
+
+using namespace std;
+using namespace holang;
+
+void ForNode::print(int offset) {
+  print_offset(offset);
+  cout << "for " << var->name << " : " << var->index << endl;
+  iterable->print(offset + 1);
+
+  print_offset(offset);
+  cout << "do " << endl;
+  if (body != nullptr) {
+    body->print(offset + 1);
+  }
+}
+
+void ForNode::code_gen(CodeSequence *codes) {
+  // a literal range is not allocated
+  auto *range = dynamic_cast<RangeNode *>(iterable);
+  LoopKind kind;
+  if (range != nullptr) {
+    range->first->code_gen(codes);
+    range->last->code_gen(codes);
+    kind = LoopKind::BOUNDS;
+  } else {
+    iterable->code_gen(codes);
+    kind = LoopKind::ITERABLE;
+  }
+
+  // the loop stores to a plain slot, from which a captured variable is
+  // assigned
+  int loop_var = var->captured ? slot + 2 : var->index;
+  codes->append(Instruction::LOOP_PREP);
+  codes->append((int)kind);
+  codes->append(loop_var);
+  codes->append(slot);
+  int from_prep = codes->size();
+  codes->append(0); // dummy
+  codes->append(-1); // no fallback
+
+  int to_body = codes->size();
+  if (var->captured) {
+    codes->append(Instruction::LOAD_LOCAL);
+    codes->append(loop_var);
+    codes->append(Instruction::STORE_CELL);
+    codes->append(var->index);
+    codes->append(Instruction::POP);
+  }
+  if (body != nullptr) {
+    body->code_gen(codes);
+    codes->append(Instruction::POP);
+  }
+  codes->append(Instruction::LOOP_STEP);
+  codes->append(loop_var);
+  codes->append(slot);
+  codes->append(to_body);
+
+  codes->patch(from_prep, codes->size());
+  codes->append(Instruction::PUT_BOOL);
+  codes->append(true);
+}
@@ -5,7 +5,7 @@ using namespace holang;
 
 void FuncDefNode::print(int offset) {
   print_offset(offset);
-  cout << "FuncDef " << name << endl;
+  cout << (generator ? "FuncDef(generator) " : "FuncDef ") << name << endl;
   body->print(offset + 1);
 }
 
@@ -17,5 +17,7 @@ void FuncDefNode::code_gen(CodeSequence *codes) {
 
   codes->append(Instruction::DEF_FUNC);
   codes->append(&name);
-  codes->append((Object *)new Func(body_code));
+  auto *func = new Func(std::move(body_code), local_size);
+  func->generator = generator;
+  codes->append((Object *)func);
 }
@@ -9,6 +9,7 @@ void IdentNode::print(int offset) {
 }
 
 void IdentNode::code_gen(CodeSequence *codes) {
-  codes->append(Instruction::LOAD_LOCAL);
+  codes->append(var->captured ? Instruction::LOAD_CELL
+                              : Instruction::LOAD_LOCAL);
   codes->append(index);
 }
@@ -35,12 +35,12 @@ void IfNode::code_gen(CodeSequence *codes) {
   if (els == nullptr) {
     // nilの概念ができたらnilにする
     codes->append(Instruction::PUT_INT);
-    codes->append(0);
+    codes->append((int64_t)0);
   } else {
     els->code_gen(codes);
   }
   int to_end = codes->size();
 
-  codes->at(from_if).ival = to_else;
-  codes->at(from_then).ival = to_end;
+  codes->patch(from_if, to_else);
+  codes->patch(from_then, to_end);
 }
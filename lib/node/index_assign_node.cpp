@@ -0,0 +1,19 @@
+#include "holang/node.hpp"
+
+using namespace std;
+using namespace holang;
+
+void IndexAssignNode::print(int offset) {
+  print_offset(offset);
+  cout << "IndexAssign" << endl;
+  lhs->recv->print(offset + 1);
+  lhs->index->print(offset + 1);
+  rhs->print(offset + 1);
+}
+
+void IndexAssignNode::code_gen(CodeSequence *codes) {
+  lhs->recv->code_gen(codes);
+  lhs->index->code_gen(codes);
+  rhs->code_gen(codes);
+  codes->append(Instruction::IDX_STORE);
+}
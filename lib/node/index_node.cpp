@@ -0,0 +1,17 @@
+#include "holang/node.hpp"
+
+using namespace std;
+using namespace holang;
+
+void IndexNode::print(int offset) {
+  print_offset(offset);
+  cout << "Index" << endl;
+  recv->print(offset + 1);
+  index->print(offset + 1);
+}
+
+void IndexNode::code_gen(CodeSequence *codes) {
+  recv->code_gen(codes);
+  index->code_gen(codes);
+  codes->append(Instruction::IDX_LOAD);
+}
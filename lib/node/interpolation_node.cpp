@@ -0,0 +1,20 @@
+#include "holang/node.hpp"
+
+using namespace std;
+using namespace holang;
+
+void InterpolationNode::print(int offset) {
+  print_offset(offset);
+  cout << "Interpolation" << endl;
+  for (Node *part : parts) {
+    part->print(offset + 1);
+  }
+}
+
+void InterpolationNode::code_gen(CodeSequence *codes) {
+  for (Node *part : parts) {
+    part->code_gen(codes);
+  }
+  codes->append(Instruction::CONCAT);
+  codes->append((int)parts.size());
+}
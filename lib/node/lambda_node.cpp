@@ -6,15 +6,26 @@ using namespace holang;
 void LambdaNode::print(int offset) {
   print_offset(offset);
   cout << "Lambda" << endl;
-  body->print(offset + 1);
+  if (body != nullptr) {
+    body->print(offset + 1);
+  }
 }
 
 void LambdaNode::code_gen(CodeSequence *codes) {
   CodeSequence body_code(codes->source_path);
 
-  body->code_gen(&body_code);
+  if (body != nullptr) {
+    body->code_gen(&body_code);
+  } else { // an empty block returns false
+    body_code.append(Instruction::PUT_BOOL);
+    body_code.append(false);
+  }
   body_code.append(Instruction::RET);
 
-  codes->append(Instruction::PUT_LAMBDA);
-  codes->append(new Func(body_code));
+  auto *func = new Func(std::move(body_code), local_size);
+  func->captures = captures;
+  // a block capturing nothing is the same every time
+  codes->append(captures.empty() ? Instruction::PUT_LAMBDA
+                                 : Instruction::MAKE_CLOSURE);
+  codes->append(func);
 }
@@ -0,0 +1,180 @@
+#include "holang/node.hpp"
+
+using namespace std;
+using namespace holang;
+
+void LoopCallNode::print(int offset) {
+  print_offset(offset);
+  cout << "LoopCall " << name << " : " << base << endl;
+  for (const auto &arg : args) {
+    arg->print(offset + 1);
+  }
+  block->print(offset + 1);
+}
+
+// Whether `body`, compiled for the frame of a block, does the same when it
+// runs in the enclosing frame: it must not leave or suspend the frame, or
+// use self unless self is the main object there as in a block.
+static bool can_inline(const CodeSequence &body, bool self_is_main) {
+  for (size_t pc = 0; pc < body.size(); pc += encoded_size(body.op_at(pc))) {
+    switch (body.op_at(pc)) {
+    case Instruction::RET:
+    case Instruction::YIELD:
+    case Instruction::LOAD_CLASS:
+    case Instruction::PREV_ENV:
+    case Instruction::IMPORT:
+      return false;
+    case Instruction::STORE_LOCAL:
+      if (body.int_at(pc + 1) == 0) {
+        return false;
+      }
+      break;
+    case Instruction::LOAD_LOCAL:
+      if (body.int_at(pc + 1) == 0 && !self_is_main) {
+        return false;
+      }
+      break;
+    case Instruction::PUT_SELF:
+    case Instruction::DEF_FUNC:
+      if (!self_is_main) {
+        return false;
+      }
+      break;
+    default:
+      break;
+    }
+  }
+  return true;
+}
+
+// Appends `body` to `codes`, moving slot i > 0 of the block's frame to slot
+// base + i - 1 of the enclosing one, and the jump targets along with it. A
+// slot receiving a cell of the enclosing frame becomes the slot of the cell.
+static void append_relocated(CodeSequence *codes, const CodeSequence &body,
+                             int base, const vector<pair<int, int>> &captures) {
+  int shift = codes->size();
+  auto local = [base, &captures](int i) {
+    for (auto &capture : captures) {
+      if (capture.second == i) {
+        return capture.first;
+      }
+    }
+    return i <= 0 ? i : base + i - 1;
+  };
+  auto target = [shift](int pc) { return pc < 0 ? pc : shift + pc; };
+
+  for (size_t pc = 0; pc < body.size(); pc += encoded_size(body.op_at(pc))) {
+    Instruction op = body.op_at(pc);
+    codes->append(op);
+    for (int i = 0; i < operand_count(op); i++) {
+      size_t at = pc + 1 + i * CodeSequence::OPERAND_SIZE;
+      if (op == Instruction::MAKE_CLOSURE) {
+        // the cells it takes are in the enclosing frame now
+        auto *func = new Func(*body.constant_at(at).funcval);
+        for (auto &capture : func->captures) {
+          capture.first = local(capture.first);
+        }
+        codes->append(func);
+        continue;
+      }
+      if (is_constant_operand(op, i)) {
+        codes->append_constant(body.constant_at(at));
+        continue;
+      }
+      int v = body.int_at(at);
+      switch (op) {
+      case Instruction::LOAD_LOCAL:
+      case Instruction::STORE_LOCAL:
+      case Instruction::MAKE_CELL:
+      case Instruction::LOAD_CELL:
+      case Instruction::STORE_CELL:
+        v = local(v);
+        break;
+      case Instruction::JUMP:
+      case Instruction::JUMP_IF:
+      case Instruction::JUMP_IFNOT:
+        v = target(v);
+        break;
+      case Instruction::LOOP_PREP: // kind, var, slot, exit_pc, fallback_pc
+        v = i == 1 || i == 2 ? local(v) : i >= 3 ? target(v) : v;
+        break;
+      case Instruction::LOOP_STEP: // var, slot, body_pc
+        v = i < 2 ? local(v) : target(v);
+        break;
+      default:
+        break;
+      }
+      codes->append(v);
+    }
+  }
+}
+
+// Puts the block made of its body compiled for inlining, so that nested
+// loops compile each body once.
+static void append_block(CodeSequence *codes, CodeSequence body,
+                         const LambdaNode *block) {
+  if (body.size() == 0) { // an empty block returns false
+    body.append(Instruction::PUT_BOOL);
+    body.append(false);
+  }
+  body.append(Instruction::RET);
+  auto *func = new Func(std::move(body), block->get_local_size());
+  func->captures = block->get_captures();
+  codes->append(func->captures.empty() ? Instruction::PUT_LAMBDA
+                                       : Instruction::MAKE_CLOSURE);
+  codes->append(func);
+}
+
+void LoopCallNode::code_gen(CodeSequence *codes) {
+  // the receiver is already on the stack
+  CodeSequence body(codes->source_path);
+  if (block->get_body() != nullptr) {
+    block->get_body()->code_gen(&body);
+  }
+  for (Node *arg : args) {
+    arg->code_gen(codes);
+  }
+  if (!can_inline(body, self_is_main)) {
+    append_block(codes, std::move(body), block);
+    codes->append(Instruction::CALL_FUNC);
+    codes->append(&name);
+    codes->append((int)args.size() + 1);
+    return;
+  }
+
+  int var = block->get_params().empty() ? -1 : base;
+  codes->append(Instruction::LOOP_PREP);
+  codes->append((int)(args.empty() ? LoopKind::TIMES : LoopKind::BOUNDS));
+  codes->append(var);
+  codes->append(slot);
+  int from_prep = codes->size();
+  codes->append(0); // dummy
+  int from_fallback = codes->size();
+  codes->append(0); // dummy
+
+  int to_body = codes->size();
+  if (body.size() != 0) {
+    append_relocated(codes, body, base, block->get_captures());
+    codes->append(Instruction::POP);
+  }
+  codes->append(Instruction::LOOP_STEP);
+  codes->append(var);
+  codes->append(slot);
+  codes->append(to_body);
+
+  codes->patch(from_prep, codes->size());
+  codes->append(Instruction::PUT_BOOL);
+  codes->append(true);
+  codes->append(Instruction::JUMP);
+  int from_end = codes->size();
+  codes->append(0); // dummy
+
+  // not Ints, or not the builtin method: call the method with the block
+  codes->patch(from_fallback, codes->size());
+  append_block(codes, std::move(body), block);
+  codes->append(Instruction::CALL_FUNC);
+  codes->append(&name);
+  codes->append((int)args.size() + 1);
+
+  codes->patch(from_end, codes->size());
+}
@@ -0,0 +1,22 @@
+#include "holang/node.hpp"
+
+using namespace std;
+using namespace holang;
+
+void MakeCellsNode::print(int offset) {
+  print_offset(offset);
+  cout << "MakeCells";
+  for (int slot : slots) {
+    cout << " " << slot;
+  }
+  cout << endl;
+  body->print(offset + 1);
+}
+
+void MakeCellsNode::code_gen(CodeSequence *codes) {
+  for (int slot : slots) {
+    codes->append(Instruction::MAKE_CELL);
+    codes->append(slot);
+  }
+  body->code_gen(codes);
+}
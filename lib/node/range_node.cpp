@@ -0,0 +1,17 @@
+#include "holang/node.hpp"
+
+using namespace std;
+using namespace holang;
+
+void RangeNode::print(int offset) {
+  print_offset(offset);
+  cout << "Range" << endl;
+  first->print(offset + 1);
+  last->print(offset + 1);
+}
+
+void RangeNode::code_gen(CodeSequence *codes) {
+  first->code_gen(codes);
+  last->code_gen(codes);
+  codes->append(Instruction::NEW_RANGE);
+}
@@ -12,6 +12,6 @@ void SignChangeNode::print(int offset) {
 void SignChangeNode::code_gen(CodeSequence *codes) {
   body->code_gen(codes);
   codes->append(Instruction::PUT_INT);
-  codes->append(-1);
+  codes->append((int64_t)-1);
   codes->append(Instruction::MUL);
 }
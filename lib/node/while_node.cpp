@@ -10,19 +10,26 @@ void WhileNode::print(int offset) {
 
   print_offset(offset);
   cout << "do " << endl;
-  body->print(offset + 1);
+  if (body != nullptr) {
+    body->print(offset + 1);
+  }
 }
 
 void WhileNode::code_gen(CodeSequence *codes) {
   int to_cond = codes->size();
   cond->code_gen(codes);
   codes->append(Instruction::JUMP_IFNOT);
+  int from_cond = codes->size();
   codes->append(0); // dummy
-  int from_cond = codes->size() - 1;
 
-  body->code_gen(codes);
+  if (body != nullptr) {
+    body->code_gen(codes);
+    codes->append(Instruction::POP);
+  }
   codes->append(Instruction::JUMP);
   codes->append(to_cond);
 
-  codes->at(from_cond).ival = codes->size();
+  codes->patch(from_cond, codes->size());
+  codes->append(Instruction::PUT_BOOL);
+  codes->append(true);
 }
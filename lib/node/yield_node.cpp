@@ -0,0 +1,22 @@
+#include "holang/node.hpp"
+
+using namespace std;
+using namespace holang;
+
+void YieldNode::print(int offset) {
+  print_offset(offset);
+  cout << "Yield" << endl;
+  if (expr != nullptr) {
+    expr->print(offset + 1);
+  }
+}
+
+void YieldNode::code_gen(CodeSequence *codes) {
+  if (expr != nullptr) {
+    expr->code_gen(codes);
+  } else {
+    codes->append(Instruction::PUT_BOOL);
+    codes->append(false);
+  }
+  codes->append(Instruction::YIELD);
+}
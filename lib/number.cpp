@@ -0,0 +1,251 @@
+#include "holang/number.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+
+using namespace std;
+using namespace holang;
+
+static const char digit_pairs[] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static int count_digits(uint64_t n) {
+  int digits = 1;
+  while (true) {
+    if (n < 10) {
+      return digits;
+    }
+    if (n < 100) {
+      return digits + 1;
+    }
+    if (n < 1000) {
+      return digits + 2;
+    }
+    if (n < 10000) {
+      return digits + 3;
+    }
+    n /= 10000;
+    digits += 4;
+  }
+}
+
+char *holang::format_int(char *buf, int64_t value) {
+  uint64_t u = value;
+  if (value < 0) {
+    *buf++ = '-';
+    u = 0 - u;
+  }
+
+  int len = count_digits(u);
+  char *p = buf + len;
+  while (u >= 100) {
+    unsigned index = (u % 100) * 2;
+    u /= 100;
+    *--p = digit_pairs[index + 1];
+    *--p = digit_pairs[index];
+  }
+  if (u >= 10) {
+    unsigned index = u * 2;
+    *--p = digit_pairs[index + 1];
+    *--p = digit_pairs[index];
+  } else {
+    *--p = '0' + u;
+  }
+  return buf + len;
+}
+
+static bool is_digit(char c) { return static_cast<unsigned>(c - '0') < 10; }
+
+char *holang::format_double(char *buf, double value) {
+  if (std::isnan(value)) {
+    memcpy(buf, "nan", 3);
+    return buf + 3;
+  }
+  if (std::isinf(value)) {
+    if (value < 0) {
+      *buf++ = '-';
+    }
+    memcpy(buf, "inf", 3);
+    return buf + 3;
+  }
+
+  // the shortest digits which read back as `value`, as d.ddde[+-]XX
+  char sci[DOUBLE_CHARS_MAX];
+  char *sci_end = to_chars(sci, sci + sizeof(sci), value,
+                           chars_format::scientific)
+                      .ptr;
+  char *e = static_cast<char *>(memchr(sci, 'e', sci_end - sci));
+  int exponent = 0;
+  from_chars(e[1] == '+' ? e + 2 : e + 1, sci_end, exponent);
+  char digits[DOUBLE_CHARS_MAX];
+  int count = 0;
+  for (const char *p = sci; p != e; p++) {
+    if (is_digit(*p)) {
+      digits[count++] = *p;
+    }
+  }
+
+  // laid out as "%.Pg" would with P = max(15, count): an exponent too
+  // large or too small for P digits in fixed notation stays scientific
+  int len = 0;
+  if (exponent < -4 || exponent >= max(15, count)) {
+    len = sci_end - sci;
+    memcpy(buf, sci, len);
+  } else {
+    if (signbit(value)) {
+      buf[len++] = '-';
+    }
+    if (exponent < 0) {
+      buf[len++] = '0';
+      buf[len++] = '.';
+      memset(buf + len, '0', -exponent - 1);
+      len += -exponent - 1;
+      memcpy(buf + len, digits, count);
+      len += count;
+    } else {
+      int whole = exponent + 1;
+      for (int i = 0; i < whole; i++) {
+        buf[len++] = i < count ? digits[i] : '0';
+      }
+      if (count > whole) {
+        buf[len++] = '.';
+        memcpy(buf + len, digits + whole, count - whole);
+        len += count - whole;
+      }
+    }
+  }
+
+  // keep it distinguishable from an integer
+  if (memchr(buf, '.', len) == nullptr && memchr(buf, 'e', len) == nullptr) {
+    buf[len++] = '.';
+    buf[len++] = '0';
+  }
+  return buf + len;
+}
+
+const char *holang::parse_int(const char *first, const char *last,
+                              int64_t &out) {
+  const char *p = first;
+  bool negative = false;
+  if (p != last && (*p == '-' || *p == '+')) {
+    negative = *p == '-';
+    p++;
+  }
+
+  const char *digits = p;
+  uint64_t value = 0;
+  const uint64_t limit =
+      negative ? static_cast<uint64_t>(numeric_limits<int64_t>::max()) + 1
+               : numeric_limits<int64_t>::max();
+  while (p != last && is_digit(*p)) {
+    unsigned d = *p - '0';
+    if (value > (limit - d) / 10) {
+      return first;
+    }
+    value = value * 10 + d;
+    p++;
+  }
+  if (p == digits) {
+    return first;
+  }
+
+  out = negative ? static_cast<int64_t>(0 - value) : value;
+  return p;
+}
+
+static const double powers_of_ten[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+const char *holang::parse_double(const char *first, const char *last,
+                                 double &out) {
+  const char *p = first;
+  bool negative = false;
+  if (p != last && (*p == '-' || *p == '+')) {
+    negative = *p == '-';
+    p++;
+  }
+
+  uint64_t mantissa = 0;
+  int significant = 0;
+  int exponent = 0;
+  bool has_digit = false;
+  bool truncated = false;
+
+  auto take_digit = [&](unsigned d) {
+    has_digit = true;
+    if (significant < 19) {
+      mantissa = mantissa * 10 + d;
+      if (mantissa != 0) {
+        significant++;
+      }
+      return true;
+    }
+    truncated |= d != 0;
+    return false;
+  };
+
+  while (p != last && is_digit(*p)) {
+    if (!take_digit(*p - '0')) {
+      exponent++;
+    }
+    p++;
+  }
+  if (p != last && *p == '.' && p + 1 != last && is_digit(p[1])) {
+    p++;
+    while (p != last && is_digit(*p)) {
+      if (take_digit(*p - '0')) {
+        exponent--;
+      }
+      p++;
+    }
+  }
+  if (!has_digit) {
+    return first;
+  }
+
+  if (p != last && (*p == 'e' || *p == 'E')) {
+    const char *q = p + 1;
+    bool exp_negative = false;
+    if (q != last && (*q == '-' || *q == '+')) {
+      exp_negative = *q == '-';
+      q++;
+    }
+    if (q != last && is_digit(*q)) {
+      int e = 0;
+      while (q != last && is_digit(*q)) {
+        if (e < 100000) {
+          e = e * 10 + (*q - '0');
+        }
+        q++;
+      }
+      exponent += exp_negative ? -e : e;
+      p = q;
+    }
+  }
+
+  // Clinger's fast path: both the mantissa and the power of ten are exact
+  if (!truncated && mantissa <= (uint64_t(1) << 53) && -22 <= exponent &&
+      exponent <= 22) {
+    double value = static_cast<double>(mantissa);
+    if (exponent < 0) {
+      value /= powers_of_ten[-exponent];
+    } else {
+      value *= powers_of_ten[exponent];
+    }
+    out = negative ? -value : value;
+    return p;
+  }
+
+  string str(first, p);
+  out = strtod(str.c_str(), nullptr);
+  return p;
+}
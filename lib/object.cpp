@@ -1,5 +1,7 @@
 #include "holang/object.hpp"
 #include "holang.hpp"
+#include "holang/cell.hpp"
+#include "holang/output.hpp"
 
 using namespace holang;
 
@@ -15,6 +17,8 @@ Func *Object::find_method(const std::string &method_name) {
   }
 }
 
+void Object::write_to(OutputBuffer &out) { out.write(to_s()); }
+
 Object *Object::find_field(const std::string &field_name) {
   auto it = fields.find(field_name);
   if (it != fields.end()) {
@@ -27,24 +31,41 @@ Object *Object::find_field(const std::string &field_name) {
   }
 }
 
-Klass Klass::Int{"Int"};
-Klass Klass::String{"String"};
+thread_local Klass *Klass::Int = nullptr;
+thread_local Klass *Klass::Double = nullptr;
+thread_local Klass *Klass::BigInt = nullptr;
+thread_local Klass *Klass::String = nullptr;
+thread_local Klass *Klass::Array = nullptr;
+thread_local Klass *Klass::Hash = nullptr;
+thread_local Klass *Klass::StringBuilder = nullptr;
+thread_local Klass *Klass::Range = nullptr;
+thread_local Klass *Klass::Lazy = nullptr;
+thread_local Klass *Klass::File = nullptr;
+thread_local Klass *Klass::FileWriter = nullptr;
+thread_local Klass *Klass::Future = nullptr;
+thread_local Klass *Klass::Coroutine = nullptr;
+thread_local Klass *Klass::IO = nullptr;
+thread_local Klass *Klass::Stream = nullptr;
+thread_local Klass *Klass::Channel = nullptr;
+
+Klass Cell::tag("Cell");
 
-void Klass::init() {
-  std::function<Object *(const Klass)> nnn = &Klass::new_object;
-  auto self = this;
-  NativeFunc func = [=](Value *, Value *, int) {
-    return Value(self->new_object());
-  };
-  methods["new"] = new Func(func);
+// Foo.new(); an instance of Foo calling new() makes another one
+static Value new_object_func(Value *self, Value *, int) {
+  auto *klass = dynamic_cast<Klass *>(self->objval);
+  return Value((klass != nullptr ? klass : self->objval->klass)->new_object());
 }
 
+void Klass::init() { methods["new"] = new Func(new_object_func); }
+
 Func *Value::find_method(const std::string &name) {
   switch (type) {
   case Type::OBJECT:
     return objval->find_method(name);
   case Type::INT:
-    return Klass::Int.find_method(name);
+    return Klass::Int->find_method(name);
+  case Type::DOUBLE:
+    return Klass::Double->find_method(name);
   default:
     std::cerr << "find_method: " << this->to_s() << std::endl;
     exit(1);
@@ -0,0 +1,83 @@
+#include "holang/output.hpp"
+#include "holang.hpp"
+#include "holang/isolate.hpp"
+#include <cerrno>
+#include <iostream>
+#include <unistd.h>
+
+using namespace std;
+using namespace holang;
+
+OutputBuffer::OutputBuffer(int fd, size_t capacity)
+    : fd(fd), buf(new char[capacity]), capacity(capacity),
+      line_buffered(isatty(fd)) {}
+
+OutputBuffer::~OutputBuffer() {
+  flush();
+  delete[] buf;
+}
+
+void OutputBuffer::write(Value &val) {
+  switch (val.type) {
+  case Type::INT:
+    write(static_cast<int64_t>(val.ival));
+    break;
+  case Type::DOUBLE:
+    write(val.dval);
+    break;
+  case Type::BOOL:
+    if (val.bval) {
+      write("true", 4);
+    } else {
+      write("false", 5);
+    }
+    break;
+  case Type::OBJECT:
+    val.objval->write_to(*this);
+    break;
+  default:
+    write(val.to_s());
+    break;
+  }
+}
+
+void OutputBuffer::flush() {
+  if (pos != 0) {
+    write_fd(buf, pos);
+    pos = 0;
+  }
+}
+
+void OutputBuffer::write_slow(const char *data, size_t size) {
+  flush();
+  if (size >= capacity) {
+    write_fd(data, size);
+  } else {
+    memcpy(buf, data, size);
+    pos = size;
+  }
+}
+
+void OutputBuffer::write_fd(const char *data, size_t size) {
+  while (size != 0) {
+    ssize_t written = ::write(fd, data, size);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      cerr << "write error: " << strerror(errno) << endl;
+      return;
+    }
+    data += written;
+    size -= written;
+  }
+}
+
+OutputBuffer &holang::standard_output() {
+  Isolate *isolate = Isolate::current();
+  if (isolate != nullptr) {
+    return isolate->output();
+  }
+  static OutputBuffer out(STDOUT_FILENO);
+  return out;
+}
@@ -0,0 +1,196 @@
+#include "holang/parallel.hpp"
+#include "holang/bind_builtins.hpp"
+#include "holang/vm.hpp"
+#include <algorithm>
+#include <set>
+#include <unordered_set>
+
+using namespace holang;
+
+// Natives which only read or change their receiver and arguments, and
+// create objects. The objects a safe block can reach are the ones it
+// creates (and ints), so these can not touch anything shared.
+static const std::unordered_set<std::string> &local_natives() {
+  static const std::unordered_set<std::string> names = {
+      "new",    "next",  "times",       "upto",   "to_f",    "to_i",
+      "to_s",   "to_a",  "size",        "[]",     "[]=",     "fetch",
+      "has_key", "delete", "keys",      "values", "each",    "map",
+      "filter", "reject", "first",      "take",   "take_while",
+      "lazy",   "sum",   "sort",        "push",   "pop",     "find",
+      "lines",  "reverse", "slice",     "split",  "starts_with",
+      "strip",  "append", "clear",
+  };
+  return names;
+}
+
+// Chunks per thread: enough to even out blocks of uneven cost.
+static const int64_t CHUNKS_PER_THREAD = 4;
+
+namespace {
+class SafetyCheck {
+public:
+  SafetyCheck() {
+    Isolate *isolate = Isolate::current();
+    objects.push_back(isolate->main_obj);
+    for (Klass *klass :
+         {Klass::Int, Klass::Double, Klass::BigInt, Klass::String,
+          Klass::Array, Klass::Hash, Klass::StringBuilder, Klass::Range,
+          Klass::Lazy, Klass::File, Klass::FileWriter, Klass::Future,
+          Klass::Coroutine, Klass::IO, Klass::Stream, Klass::Channel}) {
+      objects.push_back(klass);
+    }
+    // user classes, and builtins reopened by scripts
+    for (auto &field : isolate->main_obj->fields) {
+      if (dynamic_cast<Klass *>(field.second) != nullptr) {
+        objects.push_back(field.second);
+      }
+    }
+  }
+
+  // a closure shares the variables it captured with other frames
+  bool func(Func *func) {
+    if (func->type == FBUILTIN || func->generator || func->block != nullptr) {
+      return false;
+    }
+    // a recursive call is safe if the rest of the body is
+    if (!visited.insert(func).second) {
+      return true;
+    }
+    CodeSequence &body = func->body;
+    for (size_t pc = 0; pc < body.size();) {
+      Instruction op = body.op_at(pc);
+      switch (op) {
+      case Instruction::DEF_FUNC:
+      case Instruction::LOAD_CLASS:
+      case Instruction::PREV_ENV:
+      case Instruction::IMPORT:
+      case Instruction::YIELD:
+        return false;
+      case Instruction::PUT_LAMBDA:
+      case Instruction::MAKE_CLOSURE: // of the locals of this block
+        if (!this->func(body.constant_at(pc + 1).funcval)) {
+          return false;
+        }
+        break;
+      case Instruction::CALL_FUNC:
+        if (!call(*body.constant_at(pc + 1).sval)) {
+          return false;
+        }
+        break;
+      default:
+        break;
+      }
+      pc += encoded_size(op);
+    }
+    return true;
+  }
+
+private:
+  // every method the call may dispatch to must be safe
+  bool call(const std::string &name) {
+    bool found = false;
+    for (Object *object : objects) {
+      auto it = object->methods.find(name);
+      if (it == object->methods.end()) {
+        continue;
+      }
+      found = true;
+      Func *method = it->second;
+      if (method->type == FBUILTIN ? local_natives().count(name) == 0
+                                   : !func(method)) {
+        return false;
+      }
+    }
+    return found;
+  }
+
+  std::vector<Object *> objects;
+  std::set<Func *> visited;
+};
+} // namespace
+
+bool Parallel::is_safe(Func *func) { return SafetyCheck().func(func); }
+
+// Calls `func` with first, first + 1, ..., first + count - 1, storing the
+// results in `results` unless it is nullptr.
+static void run_indices(Value *self, Func *func, int64_t first, int64_t count,
+                        Value *results) {
+  if (count <= 0) {
+    return;
+  }
+
+  Scheduler *scheduler = nullptr;
+  if (count > 1 && Parallel::is_safe(func)) {
+    scheduler = &Isolate::current()->scheduler();
+    if (scheduler->get_worker_count() < 2) {
+      scheduler = nullptr;
+    }
+  }
+  if (scheduler == nullptr) {
+    for (int64_t i = 0; i < count; i++) {
+      Value index(first + i);
+      Value ret = call_func_argc_one(self, func, &index);
+      if (results != nullptr) {
+        results[i] = ret;
+      }
+    }
+    return;
+  }
+
+  // the caller runs chunks too while it awaits
+  int64_t threads = scheduler->get_worker_count() + 1;
+  int64_t chunks = std::min(count, threads * CHUNKS_PER_THREAD);
+  std::vector<Future *> futures;
+  futures.reserve(chunks);
+  for (int64_t c = 0; c < chunks; c++) {
+    int64_t lo = count * c / chunks;
+    int64_t hi = count * (c + 1) / chunks;
+    futures.push_back(
+        scheduler->submit([func, first, lo, hi, results](HolangVM *vm) {
+          for (int64_t i = lo; i < hi; i++) {
+            Value index(first + i);
+            Value ret = vm->invoke(func, &index, 1);
+            if (results != nullptr) {
+              results[i] = ret;
+            }
+          }
+          return Value(true);
+        }));
+  }
+  for (Future *future : futures) {
+    scheduler->await(future);
+  }
+}
+
+// n.parallel_times { |i| }: n.times { |i| } on every core
+static bool int_parallel_times(int64_t n, Func *block) {
+  Value self(n);
+  run_indices(&self, block, 0, n, nullptr);
+  return true;
+}
+
+// n.parallel_map { |i| }: the block's values for 0 up to n - 1
+static Array *int_parallel_map(int64_t n, Func *block) {
+  Value self(n);
+  std::vector<Value> results(std::max<int64_t>(n, 0));
+  run_indices(&self, block, 0, results.size(), results.data());
+  return new Array(std::move(results));
+}
+
+// (a..b).parallel_map { |i| }: the block's values for a up to b
+static Array *range_parallel_map(Range *range, Func *block) {
+  Value self((Object *)range);
+  std::vector<Value> results(
+      std::max<int64_t>(range->last - range->first + 1, 0));
+  run_indices(&self, block, range->first, results.size(), results.data());
+  return new Array(std::move(results));
+}
+
+void Parallel::init() {
+  Klass::Int->set_method("parallel_times",
+                         new Func(bind_method<&int_parallel_times>()));
+  Klass::Int->set_method("parallel_map",
+                         new Func(bind_method<&int_parallel_map>()));
+  Klass::Range->set_method("parallel_map",
+                           new Func(bind_method<&range_parallel_map>()));
+}
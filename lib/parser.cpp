@@ -26,6 +26,13 @@ void Parser::consume_newlines() {
 
 // ----- top level ----- //
 
+// `body` of the current frame, giving a cell to each of its variables which
+// blocks captured
+Node *Parser::with_cells(Node *body) {
+  vector<int> slots = variable_table.cells();
+  return slots.empty() ? body : new MakeCellsNode(slots, body);
+}
+
 Node *Parser::read_toplevel() {
   Node *root = nullptr;
 
@@ -39,7 +46,7 @@ Node *Parser::read_toplevel() {
       root = node;
     }
   }
-  return root;
+  return root != nullptr ? with_cells(root) : root;
 }
 
 // ----- statement ----- //
@@ -56,6 +63,8 @@ Node *Parser::read_stmt() {
     node = read_import();
   } else if (is_next(TokenType::While)) {
     node = read_while();
+  } else if (is_next(TokenType::For)) {
+    node = read_for();
   } else if (is_next(TokenType::Return)) {
     node = read_return();
   } else if (is_next(TokenType::BraseL)) {
@@ -87,15 +96,24 @@ Node *Parser::read_funcdef() {
   }
   take(TokenType::ParenR);
 
-  Node *body = read_suite();
+  int yields = yield_count;
+  bool self_was_main = self_is_main;
+  self_is_main = false;
+  Node *body = with_cells(read_suite());
+  self_is_main = self_was_main;
+  bool generator = yield_count != yields;
+  int local_size = variable_table.size();
   variable_table.prev();
-  return new FuncDefNode(ident->str, params, body);
+  return new FuncDefNode(ident->str, params, body, local_size, generator);
 }
 
 Node *Parser::read_klassdef() {
   take(TokenType::Class);
   Token *ident = get_ident();
+  bool self_was_main = self_is_main;
+  self_is_main = false;
   Node *body = read_suite();
+  self_is_main = self_was_main;
   return new KlassDefNode(ident->str, body);
 }
 
@@ -112,6 +130,20 @@ Node *Parser::read_while() {
   return new WhileNode(node, body);
 }
 
+Node *Parser::read_for() {
+  take(TokenType::For);
+  Token *ident = get_ident();
+  take(TokenType::In);
+  Node *iterable = read_expr();
+
+  auto *var = variable_table.insert_if_absent(ident->str);
+  int slot = variable_table.insert_hidden();
+  variable_table.insert_hidden();
+  variable_table.insert_hidden();
+  Node *body = read_suite();
+  return new ForNode(var, slot, iterable, body);
+}
+
 Node *Parser::read_return() {
   take(TokenType::Return);
   Node *node = read_expr();
@@ -144,14 +176,18 @@ Node *Parser::read_expr() { return read_assignment_expr(); }
 Node *Parser::read_assignment_expr() {
   Token *token = get();
   if (token->type == TokenType::Ident && next_token(TokenType::Assign)) {
-    auto pair = variable_table.insert_if_absent(token->str);
-    int depth = pair.first;
-    int index = pair.second;
-    return new AssignNode(new IdentNode(token->str, depth, index),
-                          read_assignment_expr());
+    int depth;
+    auto *var = variable_table.insert_if_absent(token->str, &depth);
+    return new AssignNode(new IdentNode(var, depth), read_assignment_expr());
   }
   unget();
-  return read_equal_expr();
+
+  Node *node = read_equal_expr();
+  auto *index = dynamic_cast<IndexNode *>(node);
+  if (index != nullptr && next_token(TokenType::Assign)) {
+    return new IndexAssignNode(index, read_assignment_expr());
+  }
+  return node;
 }
 
 Node *ast_binop(TokenType op, Node *lhs, Node *rhs) {
@@ -167,11 +203,19 @@ Node *Parser::read_equal_expr() {
 }
 
 Node *Parser::read_comp_expr() {
-  Node *node = read_additive_expr();
+  Node *node = read_range_expr();
   if (next_token(TokenType::LessThan))
-    return ast_binop(TokenType::LessThan, node, read_additive_expr());
+    return ast_binop(TokenType::LessThan, node, read_range_expr());
   else if (next_token(TokenType::GreaterThan))
-    return ast_binop(TokenType::GreaterThan, node, read_additive_expr());
+    return ast_binop(TokenType::GreaterThan, node, read_range_expr());
+  else
+    return node;
+}
+
+Node *Parser::read_range_expr() {
+  Node *node = read_additive_expr();
+  if (next_token(TokenType::DotDot))
+    return new RangeNode(node, read_additive_expr());
   else
     return node;
 }
@@ -213,6 +257,12 @@ Node *Parser::read_factor() {
 Node *Parser::read_prime_expr() {
   Node *node = read_prime();
   while (true) {
+    if (next_token(TokenType::BracketL)) {
+      Node *index = read_expr();
+      take(TokenType::BracketR);
+      node = new IndexNode(node, index);
+      continue;
+    }
     Node *traier = read_traier();
     if (traier == nullptr) {
       break;
@@ -232,7 +282,7 @@ Node *Parser::read_traier() {
 // ----- prime ----- //
 
 Node *Parser::read_prime() {
-  if (is_next(TokenType::Integer)) {
+  if (is_next(TokenType::Integer) || is_next(TokenType::Double)) {
     return read_number();
   } else if (is_next(TokenType::Ident)) {
     return read_name_or_funccall(false);
@@ -242,6 +292,12 @@ Node *Parser::read_prime() {
     return new BoolLiteralNode(false);
   } else if (is_next(TokenType::String)) {
     return read_string();
+  } else if (is_next(TokenType::StringBegin)) {
+    return read_interpolation();
+  } else if (is_next(TokenType::BracketL)) {
+    return read_array();
+  } else if (is_next(TokenType::Yield)) {
+    return read_yield();
   }
   exit_by_unexpected("something prime", get());
   return nullptr;
@@ -249,7 +305,10 @@ Node *Parser::read_prime() {
 
 Node *Parser::read_number() {
   Token *token = get();
-  return new IntLiteralNode(token->i);
+  if (token->type == TokenType::Double) {
+    return new DoubleLiteralNode(token->d);
+  }
+  return new IntLiteralNode((int64_t)token->i);
 }
 
 Node *Parser::read_string() {
@@ -257,6 +316,51 @@ Node *Parser::read_string() {
   return new StringLiteralNode(token->str);
 }
 
+Node *Parser::read_interpolation() {
+  vector<Node *> parts;
+  Token *token = get();
+  while (true) {
+    if (!token->str.empty()) {
+      parts.push_back(new StringLiteralNode(token->str));
+    }
+    if (token->type == TokenType::StringEnd) {
+      break;
+    }
+    parts.push_back(read_expr());
+    token = get();
+    if (token->type != TokenType::StringMid &&
+        token->type != TokenType::StringEnd) {
+      exit_by_unexpected(TokenType::StringEnd, token);
+    }
+  }
+  return new InterpolationNode(parts);
+}
+
+Node *Parser::read_array() {
+  take(TokenType::BracketL);
+  vector<Node *> elements;
+  consume_newlines();
+  if (!next_token(TokenType::BracketR)) {
+    read_exprs(elements);
+    consume_newlines();
+    take(TokenType::BracketR);
+  }
+  return new ArrayLiteralNode(elements);
+}
+
+// `yield` alone yields false
+Node *Parser::read_yield() {
+  take(TokenType::Yield);
+  yield_count++;
+  Node *value = nullptr;
+  if (!is_next(TokenType::NewLine) && !is_next(TokenType::BraseR) &&
+      !is_next(TokenType::ParenR) && !is_next(TokenType::Comma) &&
+      !is_next(TokenType::TEOF)) {
+    value = read_expr();
+  }
+  return new YieldNode(value);
+}
+
 Node *Parser::read_name_or_funccall(bool is_trailer) {
   Token *ident = get();
   if (next_token(TokenType::ParenL)) {
@@ -266,20 +370,29 @@ Node *Parser::read_name_or_funccall(bool is_trailer) {
       take(TokenType::ParenR);
     }
     if (is_next(TokenType::BraseL)) {
-      args.push_back(read_block());
+      auto *block = static_cast<LambdaNode *>(read_block());
+      if (is_trailer && ((ident->str == "times" && args.empty()) ||
+                         (ident->str == "upto" && args.size() == 1))) {
+        return loop_call(ident->str, args, block);
+      }
+      args.push_back(block);
     }
     return new FuncCallNode(ident->str, args, is_trailer);
   } else {
     if (is_trailer) {
       return new RefFieldNode(ident->str);
     } else {
-      auto pair = variable_table.find(ident->str);
-      if (pair.first < 0) {
+      int depth;
+      auto *var = variable_table.find(ident->str, &depth);
+      if (var == nullptr && is_next(TokenType::BraseL)) {
+        // `spawn { ... }`: a call with only a block
+        vector<Node *> args{read_block()};
+        return new FuncCallNode(ident->str, args, is_trailer);
+      }
+      if (var == nullptr) {
         exit_by_unexpected("It is not defined", ident);
       }
-      int depth = pair.first;
-      int index = pair.second;
-      return new IdentNode(ident->str, depth, index);
+      return new IdentNode(var, depth);
     }
   }
 }
@@ -294,10 +407,15 @@ Node *Parser::read_block() {
     take(TokenType::VertialBar);
   }
 
-  variable_table.next();
+  variable_table.next_block();
   for (auto *str : params) {
     variable_table.insert(*str);
   }
+  // a yield in a block does not make the enclosing func a generator
+  int yields = yield_count;
+  // blocks are called with the main object as self
+  bool self_was_main = self_is_main;
+  self_is_main = true;
 
   consume_newlines();
   while (!is_next(TokenType::BraseR)) {
@@ -311,9 +429,36 @@ Node *Parser::read_block() {
     }
   }
   take(TokenType::BraseR);
+  yield_count = yields;
+  self_is_main = self_was_main;
 
+  if (suite != nullptr) {
+    suite = with_cells(suite);
+  }
+  int local_size = variable_table.size();
+  auto captures = variable_table.captures();
   variable_table.prev();
-  return new LambdaNode(params, suite);
+  return new LambdaNode(params, suite, local_size, captures);
+}
+
+// n.times() { |i| ... } or n.upto(m) { |i| ... }, a call which LoopCallNode
+// may run as a counted loop in the current frame. The block keeps its own
+// scope: its slots but self are reserved in the current frame under no
+// name, followed by the counter and the limit.
+Node *Parser::loop_call(const string &name, const vector<Node *> &args,
+                        LambdaNode *block) {
+  if (block->get_params().size() > 1) {
+    vector<Node *> call_args(args);
+    call_args.push_back(block);
+    return new FuncCallNode(name, call_args, true);
+  }
+  int base = variable_table.size();
+  for (int i = 1; i < block->get_local_size(); i++) {
+    variable_table.insert_hidden();
+  }
+  int slot = variable_table.insert_hidden();
+  variable_table.insert_hidden();
+  return new LoopCallNode(name, args, block, base, slot, self_is_main);
 }
 
 void Parser::read_exprs(vector<Node *> &args) {
@@ -0,0 +1,42 @@
+#include "holang/range.hpp"
+#include "holang.hpp"
+#include "holang/array.hpp"
+#include "holang/bind_builtins.hpp"
+
+using namespace holang;
+
+const std::string Range::to_s() {
+  return Value(first).to_s() + ".." + Value(last).to_s();
+}
+
+static void range_each(Range *range, Func *block) {
+  Value self((Object *)range);
+  for (int64_t i = range->first; i <= range->last; i++) {
+    Value v(i);
+    call_func_argc_one(&self, block, &v);
+    if (i == range->last) {
+      break;
+    }
+  }
+}
+
+static int64_t range_size(Range *range) {
+  return range->first > range->last ? 0 : range->last - range->first + 1;
+}
+
+static Array *range_to_a(Range *range) {
+  auto *array = new Array();
+  for (int64_t i = range->first; i <= range->last; i++) {
+    array->elements.push_back(Value(i));
+    if (i == range->last) {
+      break;
+    }
+  }
+  return array;
+}
+
+void Range::init() {
+  Klass::Range->set_method("each", new Func(bind_method<&range_each>()));
+  Klass::Range->set_method("size", new Func(bind_method<&range_size>()));
+  Klass::Range->set_method("to_a", new Func(bind_method<&range_to_a>()));
+}
@@ -0,0 +1,47 @@
+#include "holang/runtime.hpp"
+#include "holang/coroutine.hpp"
+#include "holang/string.hpp"
+#include "holang/vm.hpp"
+
+using namespace holang;
+
+Runtime::Runtime(int in_fd, int out_fd) : isolate(in_fd, out_fd) {
+  Isolate::Scope scope(&isolate);
+  vm.reset(new HolangVM(0));
+}
+
+Runtime::~Runtime() {
+  Isolate::Scope scope(&isolate);
+  vm.reset();
+}
+
+Value Runtime::run(const Module *module) {
+  Isolate::Scope scope(&isolate);
+  // the frame of the top-level code is self and its locals
+  return vm->invoke(&module->codes, module->local_size + 1, nullptr, 0);
+}
+
+void Runtime::define_function(const std::string &name, NativeFunc native) {
+  isolate.main_obj->methods[name] = new Func(native);
+}
+
+Func *Runtime::lookup_function(const std::string &name) const {
+  auto &methods = isolate.main_obj->methods;
+  auto it = methods.find(name);
+  return it != methods.end() ? it->second : nullptr;
+}
+
+Value Runtime::call(Func *fn, Value *args, int argc) {
+  Isolate::Scope scope(&isolate);
+  Value self(isolate.main_obj);
+  if (fn->type == FBUILTIN) {
+    return fn->native(&self, args, argc);
+  } else if (fn->generator) {
+    return Value((Object *)new Coroutine(fn, self, args, argc));
+  }
+  return vm->invoke(fn, args, argc);
+}
+
+Value Runtime::to_value(const std::string &str) {
+  return Value((Object *)new String(str));
+}
@@ -0,0 +1,176 @@
+#include "holang/scheduler.hpp"
+#include "holang/bind_builtins.hpp"
+#include "holang/isolate.hpp"
+#include "holang/vm.hpp"
+
+using namespace holang;
+
+// ----- Future ----- //
+
+void Future::resolve(Value v) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    value = v;
+    done.store(true, std::memory_order_release);
+  }
+  resolved.notify_all();
+}
+
+void Future::wait_for(std::chrono::microseconds timeout) {
+  std::unique_lock<std::mutex> lock(mutex);
+  resolved.wait_for(lock, timeout, [this] { return is_done(); });
+}
+
+static bool future_done(Future *future) { return future->is_done(); }
+
+void Future::init() {
+  Klass::Future->set_method("done", new Func(bind_method<&future_done>()));
+}
+
+// ----- Scheduler ----- //
+
+// How many times an idle worker looks for a task before it sleeps.
+static const int IDLE_SPINS = 64;
+// How long await() blocks before it looks for tasks to run again.
+static const std::chrono::microseconds AWAIT_POLL(500);
+
+thread_local Scheduler::Worker *Scheduler::current_worker = nullptr;
+
+Scheduler::Scheduler(Isolate *isolate, unsigned worker_count)
+    : isolate(isolate) {
+  if (worker_count == 0) {
+    worker_count = 1;
+  }
+  for (unsigned i = 0; i < worker_count; i++) {
+    workers.emplace_back(new Worker{this, i});
+  }
+  // start after every deque exists: workers steal from each other
+  for (auto &worker : workers) {
+    Worker *w = worker.get();
+    w->thread = std::thread([this, w] { work(w); });
+  }
+}
+
+Scheduler::~Scheduler() {
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex);
+    stopping = true;
+  }
+  wake.notify_all();
+  for (auto &worker : workers) {
+    worker->thread.join();
+  }
+}
+
+Future *Scheduler::spawn(Func *func, std::vector<Value> &&args) {
+  return submit([func, args](HolangVM *vm) mutable {
+    return vm->invoke(func, args.data(), args.size());
+  });
+}
+
+Future *Scheduler::submit(std::function<Value(HolangVM *)> &&body) {
+  auto *future = new Future();
+  auto *task = new Task{std::move(body), future};
+  Worker *self = current_worker;
+  if (self != nullptr && self->scheduler == this) {
+    self->deque.push(task);
+  } else {
+    std::lock_guard<std::mutex> lock(shared_mutex);
+    shared_queue.push_back(task);
+  }
+  queued.fetch_add(1);
+  wake_one();
+  return future;
+}
+
+void Scheduler::wake_one() {
+  // pairs with the sleepers/queued check in work()
+  if (sleepers.load() > 0) {
+    std::lock_guard<std::mutex> lock(sleep_mutex);
+    wake.notify_one();
+  }
+}
+
+Scheduler::Task *Scheduler::find_task(Worker *self) {
+  Task *task = nullptr;
+  if (self != nullptr) {
+    task = self->deque.pop();
+  }
+  if (task == nullptr) {
+    std::lock_guard<std::mutex> lock(shared_mutex);
+    if (!shared_queue.empty()) {
+      task = shared_queue.front();
+      shared_queue.pop_front();
+    }
+  }
+  if (task == nullptr) {
+    size_t n = workers.size();
+    size_t start = self != nullptr ? self->index + 1 : 0;
+    for (size_t i = 0; i < n && task == nullptr; i++) {
+      Worker *victim = workers[(start + i) % n].get();
+      if (victim != self) {
+        task = victim->deque.steal();
+      }
+    }
+  }
+  if (task != nullptr) {
+    queued.fetch_sub(1);
+  }
+  return task;
+}
+
+void Scheduler::run(Task *task, HolangVM *vm) {
+  Value result = task->body(vm);
+  task->future->resolve(result);
+  delete task;
+}
+
+void Scheduler::work(Worker *worker) {
+  Isolate::Scope scope(isolate);
+  current_worker = worker;
+  CodeSequence idle("<worker>");
+  HolangVM vm(0);
+  vm.codes = &idle;
+
+  int spins = 0;
+  while (true) {
+    Task *task = find_task(worker);
+    if (task != nullptr) {
+      run(task, &vm);
+      spins = 0;
+      continue;
+    }
+    if (++spins < IDLE_SPINS) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(sleep_mutex);
+    sleepers.fetch_add(1);
+    wake.wait(lock, [this] { return stopping || queued.load() > 0; });
+    sleepers.fetch_sub(1);
+    if (stopping && queued.load() == 0) {
+      break;
+    }
+    spins = 0;
+  }
+  current_worker = nullptr;
+}
+
+Value Scheduler::await(Future *future) {
+  Worker *self = current_worker;
+  if (self != nullptr && self->scheduler != this) {
+    self = nullptr;
+  }
+  // help instead of blocking: the awaited task may be queued behind us
+  HolangVM *vm = HolangVM::current();
+  while (!future->is_done()) {
+    Task *task = vm != nullptr ? find_task(self) : nullptr;
+    if (task != nullptr) {
+      run(task, vm);
+    } else {
+      future->wait_for(AWAIT_POLL);
+    }
+  }
+  return future->get();
+}
@@ -0,0 +1,226 @@
+#include "holang/stats.hpp"
+#include "holang.hpp"
+#include "holang/json.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace std;
+using namespace holang;
+
+atomic<bool> Stats::enabled(false);
+thread_local Stats::Counters *Stats::local = nullptr;
+mutex Stats::all_mutex;
+vector<Stats::Counters *> *Stats::all = new vector<Stats::Counters *>;
+string Stats::json_path;
+
+struct Stats::Totals {
+  uint64_t instructions[INSTRUCTION_SIZE] = {};
+  uint64_t pairs[INSTRUCTION_SIZE + 1][INSTRUCTION_SIZE] = {};
+  map<pair<string, string>, uint64_t> calls;
+};
+
+Stats::Counters &Stats::add_counters() {
+  local = new Counters;
+  lock_guard<mutex> lock(all_mutex);
+  all->push_back(local);
+  return *local;
+}
+
+void Stats::add_up(Totals &totals) {
+  lock_guard<mutex> all_lock(all_mutex);
+  for (Counters *c : *all) {
+    for (size_t i = 0; i < INSTRUCTION_SIZE; i++) {
+      totals.instructions[i] += c->instructions[i].load(memory_order_relaxed);
+    }
+    for (size_t i = 0; i <= INSTRUCTION_SIZE; i++) {
+      for (size_t j = 0; j < INSTRUCTION_SIZE; j++) {
+        totals.pairs[i][j] += c->pairs[i][j].load(memory_order_relaxed);
+      }
+    }
+    lock_guard<mutex> lock(c->mutex);
+    for (const auto &klass : c->calls) {
+      for (const auto &method : klass.second) {
+        totals.calls[make_pair(klass.first, method.first)] += method.second;
+      }
+    }
+  }
+}
+
+void Stats::enable(const string &path) {
+  if (enabled) {
+    return;
+  }
+  enabled = true;
+  json_path = path;
+  atexit(report_at_exit);
+}
+
+void Stats::report_at_exit() {
+  if (!enabled) {
+    return;
+  }
+  enabled = false;
+
+  if (json_path.empty()) {
+    report(cerr);
+    return;
+  }
+  ofstream ofs(json_path);
+  if (ofs.fail()) {
+    cerr << json_path << ": can not open stats file." << endl;
+    return;
+  }
+  dump_json(ofs);
+}
+
+static const string &receiver_name(const Value &self) {
+  static const string names[] = {"Int", "Double", "Bool", "Func", "Object"};
+  switch (self.type) {
+  case Type::INT:
+    return Klass::Int->get_name();
+  case Type::DOUBLE:
+    return Klass::Double->get_name();
+  case Type::OBJECT:
+    if (auto *klass = dynamic_cast<Klass *>(self.objval)) {
+      return klass->get_name();
+    } else if (self.objval->klass != nullptr) {
+      return self.objval->klass->get_name();
+    }
+    return names[4];
+  default:
+    return names[static_cast<int>(self.type)];
+  }
+}
+
+void Stats::count_call(const Value &self, const string *method_name) {
+  Counters &c = counters();
+  lock_guard<mutex> lock(c.mutex);
+  c.calls[receiver_name(self)][*method_name]++;
+}
+
+static string instruction_name(size_t index) {
+  if (index == INSTRUCTION_SIZE) {
+    return "(start)"; // the row of the first instruction executed
+  }
+  ostringstream oss;
+  oss << static_cast<Instruction>(index);
+  return oss.str();
+}
+
+namespace {
+struct PairCount {
+  size_t first;
+  size_t second;
+  uint64_t count;
+};
+
+struct CallCount {
+  const string *klass;
+  const string *method;
+  uint64_t count;
+};
+} // namespace
+
+template <typename T> static void sort_by_count(vector<T> &entries) {
+  stable_sort(entries.begin(), entries.end(),
+              [](const T &a, const T &b) { return a.count > b.count; });
+}
+
+static vector<PairCount> collect_pairs(uint64_t (*pairs)[INSTRUCTION_SIZE]) {
+  vector<PairCount> entries;
+  for (size_t i = 0; i <= INSTRUCTION_SIZE; i++) {
+    for (size_t j = 0; j < INSTRUCTION_SIZE; j++) {
+      if (pairs[i][j] != 0) {
+        entries.push_back({i, j, pairs[i][j]});
+      }
+    }
+  }
+  sort_by_count(entries);
+  return entries;
+}
+
+template <typename Map> static vector<CallCount> collect_calls(const Map &m) {
+  vector<CallCount> entries;
+  for (const auto &kv : m) {
+    entries.push_back({&kv.first.first, &kv.first.second, kv.second});
+  }
+  sort_by_count(entries);
+  return entries;
+}
+
+void Stats::report(ostream &out) {
+  Totals totals;
+  add_up(totals);
+
+  vector<PairCount> ops;
+  uint64_t total = 0;
+  for (size_t i = 0; i < INSTRUCTION_SIZE; i++) {
+    if (totals.instructions[i] != 0) {
+      ops.push_back({i, i, totals.instructions[i]});
+      total += totals.instructions[i];
+    }
+  }
+  sort_by_count(ops);
+
+  out << "--- instructions (" << total << " executed) ---" << endl;
+  for (const auto &op : ops) {
+    out << setw(12) << op.count << "  " << instruction_name(op.first) << endl;
+  }
+
+  out << "--- instruction pairs ---" << endl;
+  for (const auto &p : collect_pairs(totals.pairs)) {
+    out << setw(12) << p.count << "  " << instruction_name(p.first) << " -> "
+        << instruction_name(p.second) << endl;
+  }
+
+  out << "--- method calls ---" << endl;
+  for (const auto &c : collect_calls(totals.calls)) {
+    out << setw(12) << c.count << "  " << *c.klass << "#" << *c.method
+        << endl;
+  }
+}
+
+void Stats::dump_json(ostream &out) {
+  Totals totals;
+  add_up(totals);
+
+  out << "{\n  \"instructions\": {";
+  bool first = true;
+  for (size_t i = 0; i < INSTRUCTION_SIZE; i++) {
+    if (totals.instructions[i] == 0) {
+      continue;
+    }
+    out << (first ? "\n    " : ",\n    ");
+    write_json_string(out, instruction_name(i));
+    out << ": " << totals.instructions[i];
+    first = false;
+  }
+  out << "\n  },\n  \"pairs\": [";
+
+  first = true;
+  for (const auto &p : collect_pairs(totals.pairs)) {
+    out << (first ? "\n    " : ",\n    ") << "{\"first\": ";
+    write_json_string(out, instruction_name(p.first));
+    out << ", \"second\": ";
+    write_json_string(out, instruction_name(p.second));
+    out << ", \"count\": " << p.count << "}";
+    first = false;
+  }
+  out << "\n  ],\n  \"calls\": [";
+
+  first = true;
+  for (const auto &c : collect_calls(totals.calls)) {
+    out << (first ? "\n    " : ",\n    ") << "{\"class\": ";
+    write_json_string(out, *c.klass);
+    out << ", \"method\": ";
+    write_json_string(out, *c.method);
+    out << ", \"count\": " << c.count << "}";
+    first = false;
+  }
+  out << "\n  ]\n}" << endl;
+}
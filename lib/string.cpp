@@ -1,22 +1,303 @@
 #include "holang/string.hpp"
 #include "holang.hpp"
+#include "holang/array.hpp"
+#include "holang/bind_builtins.hpp"
+#include "holang/number.hpp"
+#include "holang/output.hpp"
+#include <algorithm>
+#include <atomic>
 
 using namespace holang;
 
-static Value reverse_func(Value *self, Value *, int) {
-  String *str = (String *)self->objval;
-  std::string rev = str->str;
+void String::write_to(OutputBuffer &out) { out.write(data(), length); }
+
+int String::compare(const String &other) const {
+  int cmp = std::memcmp(data(), other.data(), std::min(length, other.length));
+  if (cmp != 0) {
+    return cmp;
+  }
+  return length < other.length ? -1 : length > other.length;
+}
+
+namespace {
+// Stored in front of the characters of a buffer made by concat(). Strings
+// sharing the buffer each see a prefix of [0, used); bytes are only ever
+// written past `used`, by the concat() which moved it there.
+struct Room {
+  std::atomic<size_t> used;
+  size_t capacity;
+};
+} // namespace
+
+static Room *room_of(const std::shared_ptr<const char> &buffer) {
+  return reinterpret_cast<Room *>(const_cast<char *>(buffer.get()) -
+                                  sizeof(Room));
+}
+
+String *String::concat(const String &lhs, const String &rhs) {
+  size_t size = lhs.length + rhs.length;
+  if (lhs.appendable) {
+    Room *room = room_of(lhs.buffer);
+    size_t end = lhs.chars + lhs.length - lhs.buffer.get();
+    if (end + rhs.length <= room->capacity &&
+        room->used.compare_exchange_strong(end, end + rhs.length)) {
+      std::memcpy(const_cast<char *>(lhs.chars) + lhs.length, rhs.data(),
+                  rhs.length);
+      auto *str = new String(lhs.buffer, lhs.chars, size);
+      str->appendable = true;
+      return str;
+    }
+  }
+  if (size <= INLINE_CAPACITY) {
+    auto *str = new String(size);
+    std::memcpy(str->mutable_data(), lhs.data(), lhs.length);
+    std::memcpy(str->mutable_data() + lhs.length, rhs.data(), rhs.length);
+    return str;
+  }
+
+  size_t capacity = size * 2;
+  char *block = new char[sizeof(Room) + capacity];
+  auto *room = new (block) Room{{size}, capacity};
+  char *chars = block + sizeof(Room);
+  std::memcpy(chars, lhs.data(), lhs.length);
+  std::memcpy(chars + lhs.length, rhs.data(), rhs.length);
+  std::shared_ptr<const char> buffer(chars, [room, block](const char *) {
+    room->~Room();
+    delete[] block;
+  });
+  auto *str = new String(buffer, chars, size);
+  str->appendable = true;
+  return str;
+}
+
+String *String::slice(size_t offset, size_t size) {
+  return view(buffer, chars + offset, size);
+}
+
+String *String::view(const std::shared_ptr<const char> &buffer,
+                     const char *chars, size_t size) {
+  if (size <= INLINE_CAPACITY || buffer == nullptr) {
+    return new String(chars, size);
+  }
+  return new String(buffer, chars, size);
+}
+
+// 8 bytes at a time with a multiply-xorshift mix per word
+uint64_t String::hash_bytes(const char *data, size_t size) {
+  const uint64_t k = 0x9e3779b97f4a7c15ULL;
+  uint64_t h = size * k;
+  for (; size >= 8; data += 8, size -= 8) {
+    uint64_t w;
+    std::memcpy(&w, data, 8);
+    h = (h ^ w) * k;
+    h ^= h >> 29;
+  }
+  if (size != 0) {
+    uint64_t w = 0;
+    std::memcpy(&w, data, size);
+    h = (h ^ w) * k;
+    h ^= h >> 29;
+  }
+  h *= 0xbf58476d1ce4e5b9ULL;
+  return h ^ (h >> 32);
+}
+
+static std::string str_reverse(String *str) {
+  std::string rev(str->data(), str->size());
   std::reverse(rev.begin(), rev.end());
-  return Value((Object *)new String(rev));
+  return rev;
+}
+
+static bool is_space(char c) { return isspace(static_cast<unsigned char>(c)); }
+
+// slice(start, length): a negative start counts from the end and the range
+// is clipped to the string
+static String *str_slice(String *str, int64_t start, int64_t length) {
+  int64_t size = str->size();
+  start = start < 0 ? start + size : start;
+  start = std::min(std::max(start, (int64_t)0), size);
+  length = std::min(std::max(length, (int64_t)0), size - start);
+  return str->slice(start, length);
+}
+
+// split() splits at runs of whitespace; split(sep) at every sep, keeping
+// empty fields
+static Array *str_split(String *str, std::optional<String *> separator) {
+  const char *first = str->data();
+  const char *last = first + str->size();
+  auto *fields = new Array();
+  auto push = [&](const char *b, const char *e) {
+    fields->elements.push_back(Value((Object *)str->slice(b - first, e - b)));
+  };
+
+  if (!separator) {
+    const char *p = first;
+    while (true) {
+      while (p != last && is_space(*p)) {
+        p++;
+      }
+      if (p == last) {
+        break;
+      }
+      const char *begin = p;
+      while (p != last && !is_space(*p)) {
+        p++;
+      }
+      push(begin, p);
+    }
+    return fields;
+  }
+
+  String *sep = *separator;
+  if (sep->size() == 0) {
+    std::cerr << "String#split: empty separator" << std::endl;
+    exit(1);
+  }
+  const char *begin = first;
+  while (true) {
+    const char *p;
+    if (sep->size() == 1) {
+      p = static_cast<const char *>(memchr(begin, *sep->data(), last - begin));
+      p = p == nullptr ? last : p;
+    } else {
+      p = std::search(begin, last, sep->data(), sep->data() + sep->size());
+    }
+    push(begin, p);
+    if (p == last) {
+      break;
+    }
+    begin = p + sep->size();
+  }
+  return fields;
 }
 
-static Value to_i(Value *self, Value *, int) {
-  String *str = (String *)self->objval;
-  int i = stoi(str->str);
-  return Value(i);
+// lines without their terminators ("\n" or "\r\n")
+static Array *str_lines(String *str) {
+  const char *first = str->data();
+  const char *last = first + str->size();
+  auto *lines = new Array();
+  const char *begin = first;
+  while (begin != last) {
+    auto *nl = static_cast<const char *>(memchr(begin, '\n', last - begin));
+    const char *end = nl == nullptr ? last : nl;
+    const char *content_end = end;
+    if (content_end != begin && content_end[-1] == '\r') {
+      content_end--;
+    }
+    lines->elements.push_back(
+        Value((Object *)str->slice(begin - first, content_end - begin)));
+    begin = nl == nullptr ? last : nl + 1;
+  }
+  return lines;
 }
 
+static String *str_strip(String *str) {
+  const char *first = str->data();
+  const char *last = first + str->size();
+  const char *b = first;
+  while (b != last && is_space(*b)) {
+    b++;
+  }
+  const char *e = last;
+  while (e != b && is_space(e[-1])) {
+    e--;
+  }
+  return str->slice(b - first, e - b);
+}
+
+static bool str_starts_with(String *str, String *prefix) {
+  return prefix->size() <= str->size() &&
+         std::memcmp(str->data(), prefix->data(), prefix->size()) == 0;
+}
+
+// find(sub): index of the first sub, or -1
+static int64_t str_find(String *str, String *sub) {
+  const char *first = str->data();
+  const char *last = first + str->size();
+  const char *p =
+      std::search(first, last, sub->data(), sub->data() + sub->size());
+  if (p == last && sub->size() != 0) {
+    return -1;
+  }
+  return p - first;
+}
+
+// Reads the leading integer like Ruby's String#to_i: "12abc" is 12 and a
+// string without a leading integer is 0.
+static int64_t str_to_i(String *str) {
+  const char *first = str->data();
+  const char *last = first + str->size();
+  while (first != last && isspace(static_cast<unsigned char>(*first))) {
+    first++;
+  }
+  int64_t i = 0;
+  parse_int(first, last, i);
+  return i;
+}
+
+static int64_t str_size(String *str) { return str->size(); }
+
 void String::init() {
-  Klass::String.set_method("reverse", new Func((NativeFunc)reverse_func));
-  Klass::String.set_method("to_i", new Func((NativeFunc)to_i));
+  Klass::String->set_method("reverse", new Func(bind_method<&str_reverse>()));
+  Klass::String->set_method("to_i", new Func(bind_method<&str_to_i>()));
+  Klass::String->set_method("size", new Func(bind_method<&str_size>()));
+  Klass::String->set_method("slice", new Func(bind_method<&str_slice>()));
+  Klass::String->set_method("split", new Func(bind_method<&str_split>()));
+  Klass::String->set_method("lines", new Func(bind_method<&str_lines>()));
+  Klass::String->set_method("strip", new Func(bind_method<&str_strip>()));
+  Klass::String->set_method("starts_with",
+                           new Func(bind_method<&str_starts_with>()));
+  Klass::String->set_method("find", new Func(bind_method<&str_find>()));
+}
+
+// ----- StringBuilder ----- //
+
+void StringBuilder::append(const Value &v) {
+  char num[DOUBLE_CHARS_MAX];
+  switch (v.type) {
+  case Type::INT:
+    append(num, format_int(num, v.ival) - num);
+    break;
+  case Type::DOUBLE:
+    append(num, format_double(num, v.dval) - num);
+    break;
+  case Type::OBJECT:
+    if (String::is_string(v)) {
+      append(*(String *)v.objval);
+      break;
+    }
+    // fall through
+  default:
+    Value copy = v;
+    buf += copy.to_s();
+  }
+}
+
+void StringBuilder::write_to(OutputBuffer &out) { out.write(buf); }
+
+static StringBuilder *new_builder() { return new StringBuilder(); }
+
+// append(values...) appends them in order and returns the builder
+static void builder_append(StringBuilder *builder, Args values) {
+  for (const Value &v : values) {
+    builder->append(v);
+  }
+}
+
+static String *builder_to_s(StringBuilder *builder) { return builder->build(); }
+
+static int64_t builder_size(StringBuilder *builder) { return builder->size(); }
+
+static void builder_clear(StringBuilder *builder) { builder->clear(); }
+
+void StringBuilder::init() {
+  Klass::StringBuilder->methods["new"] = new Func(bind<&new_builder>());
+  Klass::StringBuilder->set_method("append",
+                                   new Func(bind_method<&builder_append>()));
+  Klass::StringBuilder->set_method("to_s",
+                                   new Func(bind_method<&builder_to_s>()));
+  Klass::StringBuilder->set_method("size",
+                                   new Func(bind_method<&builder_size>()));
+  Klass::StringBuilder->set_method("clear",
+                                   new Func(bind_method<&builder_clear>()));
 }
@@ -0,0 +1,127 @@
+#include "holang/trace.hpp"
+#include "holang/json.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace holang;
+
+atomic<bool> Trace::enabled(false);
+thread_local Trace::Buffer *Trace::local = nullptr;
+string Trace::path;
+
+static const auto trace_epoch = chrono::steady_clock::now();
+
+mutex Trace::buffers_mutex;
+vector<Trace::Buffer *> *Trace::buffers = new vector<Trace::Buffer *>;
+
+static int thread_id() {
+#ifdef SYS_gettid
+  return static_cast<int>(syscall(SYS_gettid));
+#else
+  static atomic<int> next_id(1);
+  return next_id++;
+#endif
+}
+
+Trace::Buffer &Trace::buffer() {
+  if (local == nullptr) {
+    local = new Buffer;
+    local->tid = thread_id();
+    local->events.reserve(1 << 12);
+    lock_guard<mutex> lock(buffers_mutex);
+    buffers->push_back(local);
+  }
+  return *local;
+}
+
+void Trace::add(const Event &event) {
+  Buffer &buf = buffer();
+  lock_guard<mutex> lock(buf.mutex);
+  buf.events.push_back(event);
+}
+
+void Trace::enable(const string &trace_path) {
+  if (enabled) {
+    return;
+  }
+  path = trace_path;
+  buffer(); // the thread enabling it is listed first, as the main thread
+  enabled = true;
+  atexit(write_at_exit);
+}
+
+double Trace::now() {
+  auto elapsed = chrono::steady_clock::now() - trace_epoch;
+  return chrono::duration_cast<chrono::nanoseconds>(elapsed).count() / 1000.0;
+}
+
+void Trace::begin(const string &name, const char *category) {
+  add({'B', name, category, now(), 0});
+}
+
+void Trace::end() { add({'E', string(), nullptr, now(), 0}); }
+
+void Trace::complete(const string &name, const char *category, double start) {
+  add({'X', name, category, start, now() - start});
+}
+
+void Trace::write_at_exit() {
+  if (!enabled) {
+    return;
+  }
+  enabled = false;
+
+  ofstream ofs(path);
+  if (ofs.fail()) {
+    cerr << path << ": can not open trace file." << endl;
+    return;
+  }
+
+  double exit_ts = now();
+  int pid = getpid();
+  ofs << fixed << setprecision(3);
+  ofs << "[\n{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": " << pid
+      << ", \"args\": {\"name\": \"ho\"}}";
+
+  lock_guard<mutex> buffers_lock(buffers_mutex);
+  for (Buffer *buf : *buffers) {
+    lock_guard<mutex> lock(buf->mutex);
+    ofs << ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << pid
+        << ", \"tid\": " << buf->tid << ", \"args\": {\"name\": \""
+        << (buf == buffers->front() ? "main" : "worker") << "\"}}";
+
+    // Close frames which were still running when the program exited.
+    int depth = 0;
+    for (const auto &event : buf->events) {
+      if (event.phase == 'B') {
+        depth++;
+      } else if (event.phase == 'E') {
+        depth--;
+      }
+    }
+    for (; depth > 0; depth--) {
+      buf->events.push_back({'E', string(), nullptr, exit_ts, 0});
+    }
+
+    for (const auto &event : buf->events) {
+      ofs << ",\n{\"ph\": \"" << event.phase << "\", \"pid\": " << pid
+          << ", \"tid\": " << buf->tid << ", \"ts\": " << event.ts;
+      if (event.phase != 'E') {
+        ofs << ", \"name\": ";
+        write_json_string(ofs, event.name);
+        ofs << ", \"cat\": \"" << event.category << "\"";
+      }
+      if (event.phase == 'X') {
+        ofs << ", \"dur\": " << event.dur;
+      }
+      ofs << "}";
+    }
+  }
+  ofs << "\n]" << endl;
+}
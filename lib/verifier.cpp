@@ -0,0 +1,330 @@
+#include "holang/verifier.hpp"
+#include "holang/instruction.hpp"
+#include "holang/object.hpp"
+#include <algorithm>
+#include <sstream>
+#include <vector>
+
+using namespace holang;
+
+namespace {
+// What the analysis knows at an instruction: the depth of the operand
+// stack, and the depths to return to at the PREV_ENV of each class body
+// being defined (LOAD_CLASS makes the class the frame of its body).
+struct State {
+  int depth = -1;
+  std::vector<int> classes;
+
+  bool operator==(const State &other) const {
+    return depth == other.depth && classes == other.classes;
+  }
+  bool operator!=(const State &other) const { return !(*this == other); }
+};
+
+class Analysis {
+public:
+  Analysis(CodeSequence &codes, int local_size, std::string &error)
+      : codes(codes), local_size(local_size), error(error),
+        states(codes.size()), starts(codes.size(), false) {}
+
+  bool run() {
+    if (!decode()) {
+      return false;
+    }
+    State entry;
+    entry.depth = 0;
+    if (!reach(0, entry, 0)) {
+      return false;
+    }
+    while (!work.empty()) {
+      size_t pc = work.back();
+      work.pop_back();
+      if (!step(pc)) {
+        return false;
+      }
+    }
+    codes.max_stack = max_depth;
+    return true;
+  }
+
+private:
+  // marks where instructions start, checking that their operands are there
+  // and that constant operands are in the table
+  bool decode() {
+    for (size_t pc = 0; pc < codes.size();) {
+      auto byte = static_cast<size_t>(codes.op_at(pc));
+      if (byte >= INSTRUCTION_SIZE) {
+        return fail(pc, "unknown instruction " + std::to_string(byte));
+      }
+      Instruction op = codes.op_at(pc);
+      starts[pc] = true;
+      if (pc + encoded_size(op) > codes.size()) {
+        return fail(pc, "operands past the end");
+      }
+      for (int i = 0; i < operand_count(op); i++) {
+        if (is_constant_operand(op, i) &&
+            static_cast<uint32_t>(operand(pc, i)) >=
+                codes.get_constants().size()) {
+          return fail(pc, "no constant " + std::to_string(operand(pc, i)));
+        }
+      }
+      pc += encoded_size(op);
+    }
+    return true;
+  }
+
+  bool fail(size_t pc, const std::string &what) {
+    std::ostringstream out;
+    out << "pc " << pc;
+    if (pc < codes.size() && starts[pc]) {
+      out << " (" << codes.op_at(pc) << ")";
+    }
+    out << ": " << what;
+    error = out.str();
+    return false;
+  }
+
+  // whether the frame has a slot `index`; a class body runs with the class
+  // as its frame, which has no slots but self
+  bool local(size_t pc, int64_t index, const State &state) {
+    int64_t size = state.classes.empty() ? local_size : 1;
+    if (index < 0 || index >= size) {
+      return fail(pc, "no local " + std::to_string(index) + " in " +
+                          std::to_string(size));
+    }
+    return true;
+  }
+
+  // the loop variable (-1 for none) and the two hidden slots from `slot`
+  bool loop_locals(size_t pc, int64_t var, int64_t slot, const State &state) {
+    return (var == -1 || local(pc, var, state)) && local(pc, slot, state) &&
+           local(pc, slot + 1, state);
+  }
+
+  int64_t operand(size_t pc, int i) {
+    return codes.int_at(pc + 1 + i * CodeSequence::OPERAND_SIZE);
+  }
+
+  // `to` is reached from `from` with `state`: the end of the code, or an
+  // instruction which every path must reach with the same state
+  bool reach(size_t to, const State &state, size_t from) {
+    if (to == codes.size()) {
+      return true;
+    }
+    if (to > codes.size() || !starts[to]) {
+      return fail(from, "jump to " + std::to_string(to) +
+                            ", which is not an instruction");
+    }
+    if (states[to].depth < 0) {
+      states[to] = state;
+      work.push_back(to);
+      return true;
+    }
+    if (states[to] != state) {
+      return fail(to, "reached with " + std::to_string(state.depth) +
+                          " values from pc " + std::to_string(from) +
+                          " but with " + std::to_string(states[to].depth) +
+                          " before");
+    }
+    return true;
+  }
+
+  bool step(size_t pc) {
+    Instruction op = codes.op_at(pc);
+    size_t next = pc + encoded_size(op);
+    State state = states[pc];
+    int pops = 0, pushes = 0;
+
+    switch (op) {
+    case Instruction::PUT_INT:
+    case Instruction::PUT_DOUBLE:
+    case Instruction::PUT_BOOL:
+    case Instruction::PUT_STRING:
+    case Instruction::PUT_LAMBDA:
+    case Instruction::PUT_SELF:
+    case Instruction::DEF_FUNC:
+    case Instruction::LOAD_CLASS:
+      pushes = 1;
+      break;
+    case Instruction::POP:
+    case Instruction::JUMP_IF:
+    case Instruction::JUMP_IFNOT:
+    case Instruction::RET:
+      pops = 1;
+      break;
+    case Instruction::ADD:
+    case Instruction::SUB:
+    case Instruction::MUL:
+    case Instruction::DIV:
+    case Instruction::MOD:
+    case Instruction::LESS:
+    case Instruction::GREATER:
+    case Instruction::EQUAL:
+    case Instruction::IDX_LOAD:
+    case Instruction::NEW_RANGE:
+      pops = 2;
+      pushes = 1;
+      break;
+    case Instruction::LOAD_LOCAL:
+      if (!local(pc, operand(pc, 0), state)) {
+        return false;
+      }
+      pushes = 1;
+      break;
+    case Instruction::STORE_LOCAL:
+    case Instruction::STORE_CELL:
+      if (!local(pc, operand(pc, 0), state)) {
+        return false;
+      }
+      pops = 1;
+      pushes = 1;
+      break;
+    case Instruction::LOAD_CELL:
+      if (!local(pc, operand(pc, 0), state)) {
+        return false;
+      }
+      pushes = 1;
+      break;
+    case Instruction::MAKE_CELL:
+      if (!local(pc, operand(pc, 0), state)) {
+        return false;
+      }
+      break;
+    case Instruction::MAKE_CLOSURE: // takes the cells from its frame
+      for (auto &capture : codes.constant_at(pc + 1).funcval->captures) {
+        if (!local(pc, capture.first, state)) {
+          return false;
+        }
+      }
+      pushes = 1;
+      break;
+    case Instruction::LOAD_OBJ_FIELD:
+    case Instruction::IMPORT:
+    case Instruction::YIELD:
+      pops = 1;
+      pushes = 1;
+      break;
+    case Instruction::IDX_STORE:
+      pops = 3;
+      pushes = 1;
+      break;
+    case Instruction::CALL_FUNC: // [self, arg...] -> [ret]
+      if (operand(pc, 1) < 0) {
+        return fail(pc, "negative argument count");
+      }
+      pops = operand(pc, 1) + 1;
+      pushes = 1;
+      break;
+    case Instruction::NEW_ARRAY:
+    case Instruction::CONCAT:
+      if (operand(pc, 0) < 0) {
+        return fail(pc, "negative count");
+      }
+      pops = operand(pc, 0);
+      pushes = 1;
+      break;
+    case Instruction::LOOP_PREP:
+      if (operand(pc, 0) < 0 ||
+          operand(pc, 0) > static_cast<int64_t>(LoopKind::ITERABLE)) {
+        return fail(pc, "unknown loop kind " + std::to_string(operand(pc, 0)));
+      }
+      if (!loop_locals(pc, operand(pc, 1), operand(pc, 2), state)) {
+        return false;
+      }
+      pops = static_cast<LoopKind>(operand(pc, 0)) == LoopKind::BOUNDS ? 2 : 1;
+      break;
+    case Instruction::LOOP_STEP:
+      if (!loop_locals(pc, operand(pc, 0), operand(pc, 1), state)) {
+        return false;
+      }
+      break;
+    case Instruction::JUMP:
+    case Instruction::PREV_ENV:
+      break;
+    default:
+      return fail(pc, "not executable");
+    }
+
+    if (state.depth < pops) {
+      return fail(pc, "takes " + std::to_string(pops) + " values from " +
+                          std::to_string(state.depth));
+    }
+    State after = state;
+    after.depth += pushes - pops;
+    max_depth = std::max(max_depth, after.depth);
+
+    switch (op) {
+    case Instruction::RET:
+      return true;
+    case Instruction::JUMP:
+      return reach(operand(pc, 0), after, pc);
+    case Instruction::JUMP_IF:
+    case Instruction::JUMP_IFNOT:
+      return reach(operand(pc, 0), after, pc) && reach(next, after, pc);
+    case Instruction::LOOP_PREP: // exit_pc, and fallback_pc with the operands
+      return reach(next, after, pc) && reach(operand(pc, 3), after, pc) &&
+             (operand(pc, 4) < 0 || reach(operand(pc, 4), state, pc));
+    case Instruction::LOOP_STEP:
+      return reach(operand(pc, 2), after, pc) && reach(next, after, pc);
+    case Instruction::LOAD_CLASS:
+      after.classes.push_back(after.depth);
+      break;
+    case Instruction::PREV_ENV: // back to the frame around the class body
+      if (after.classes.empty()) {
+        return fail(pc, "not in a class body");
+      }
+      after.depth = after.classes.back();
+      after.classes.pop_back();
+      break;
+    default:
+      break;
+    }
+    return reach(next, after, pc);
+  }
+
+  CodeSequence &codes;
+  int local_size;
+  std::string &error;
+  std::vector<State> states;
+  std::vector<bool> starts;
+  std::vector<size_t> work;
+  int max_depth = 0;
+};
+} // namespace
+
+bool Verifier::verify(CodeSequence &codes, int local_size,
+                      std::string &error) {
+  return Analysis(codes, local_size, error).run();
+}
+
+bool Verifier::verify_all(CodeSequence &codes, int local_size,
+                          std::string &error) {
+  if (!verify(codes, local_size, error)) {
+    return false;
+  }
+  for (size_t pc = 0; pc < codes.size(); pc += encoded_size(codes.op_at(pc))) {
+    Func *func = nullptr;
+    if (codes.op_at(pc) == Instruction::PUT_LAMBDA ||
+        codes.op_at(pc) == Instruction::MAKE_CLOSURE) {
+      func = codes.constant_at(pc + 1).funcval;
+    } else if (codes.op_at(pc) == Instruction::DEF_FUNC) {
+      func = (Func *)codes.constant_at(pc + 1 + CodeSequence::OPERAND_SIZE)
+                 .objval;
+    }
+    if (func == nullptr) {
+      continue;
+    }
+    // the cells go to slots of its frame but self
+    for (auto &capture : func->captures) {
+      if (capture.second < 1 || capture.second >= func->local_size) {
+        error = "no slot " + std::to_string(capture.second) +
+                " for a capture in " + std::to_string(func->local_size);
+        return false;
+      }
+    }
+    if (!verify_all(func->body, func->local_size, error)) {
+      return false;
+    }
+  }
+  return true;
+}
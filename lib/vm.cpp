@@ -1,40 +1,39 @@
 #include "holang/vm.hpp"
-#include "config.hpp"
 #include "holang.hpp"
 
 using namespace holang;
 
-Object *HolangVM::main_obj = nullptr;
-std::vector<string> HolangVM::import_search_path;
+thread_local HolangVM *HolangVM::running = nullptr;
 
-void HolangVM::init_import_search_path() {
-  if (import_search_path.size() != 0) {
-    return;
+Value holang::call_func_argc_zero(Value *self, Func *func) {
+  if (func->type == FBUILTIN) {
+    return func->native(self, nullptr, 0);
+  } else if (HolangVM::current() != nullptr) {
+    return HolangVM::current()->invoke(func, nullptr, 0);
+  } else {
+    HolangVM vm(0);
+    return vm.invoke(func, nullptr, 0);
   }
-
-#ifdef PATH_HOLIB
-  import_search_path.push_back(PATH_HOLIB);
-#else
-  import_search_path.push_back("/");
-#endif
 }
 
-void holang::call_func_argc_zero(Value *self, Func *func) {
+Value holang::call_func_argc_two(Value *self, Func *func, Value *args) {
   if (func->type == FBUILTIN) {
-    func->native(self, nullptr, 0);
+    return func->native(self, args, 2);
+  } else if (HolangVM::current() != nullptr) {
+    return HolangVM::current()->invoke(func, args, 2);
   } else {
     HolangVM vm(0);
-    vm.codes = &func->body;
-    vm.eval();
+    return vm.invoke(func, args, 2);
   }
 }
 
-void holang::call_func_argc_one(Value *self, Func *func, Value *arg) {
+Value holang::call_func_argc_one(Value *self, Func *func, Value *arg) {
   if (func->type == FBUILTIN) {
-    func->native(self, arg, 1);
+    return func->native(self, arg, 1);
+  } else if (HolangVM::current() != nullptr) {
+    return HolangVM::current()->invoke(func, arg, 1);
   } else {
-    HolangVM vm(arg, 1);
-    vm.codes = &func->body;
-    vm.eval();
+    HolangVM vm(0);
+    return vm.invoke(func, arg, 1);
   }
 }
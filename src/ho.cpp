@@ -1,6 +1,11 @@
 #include "holang.hpp"
+#include "holang/file.hpp"
+#include "holang/isolate.hpp"
 #include "holang/lexer.hpp"
+#include "holang/module.hpp"
 #include "holang/parser.hpp"
+#include "holang/stats.hpp"
+#include "holang/trace.hpp"
 #include "holang/vm.hpp"
 #include <fstream>
 #include <iostream>
@@ -11,57 +16,81 @@ using namespace holang;
 int main(int argc, char *argv[]) {
   bool show_ast = false;
   bool show_token = false;
+  string snapshot_path;
   if (argc < 2) {
     cerr << "require source code" << endl;
     return -1;
   }
 
-  if (argc >= 3) {
-    string opt(argv[2]);
+  for (int i = 2; i < argc; i++) {
+    string opt(argv[i]);
     if (opt == "--ast") {
       show_ast = true;
     } else if (opt == "--token") {
       show_token = true;
+    } else if (opt == "--stats" || opt.compare(0, 8, "--stats=") == 0) {
+#ifdef HOLANG_ENABLE_STATS
+      Stats::enable(opt.size() > 8 ? opt.substr(8) : "");
+#else
+      cerr << "--stats: holang was built without HOLANG_ENABLE_STATS" << endl;
+#endif
+    } else if (opt.compare(0, 8, "--trace=") == 0) {
+      Trace::enable(opt.substr(8));
+    } else if (opt.compare(0, 11, "--snapshot=") == 0) {
+      snapshot_path = opt.substr(11);
     }
   }
 
-  string src(argv[1]);
-  ifstream ifs(src);
-  if (ifs.fail()) {
-    std::cerr << src << ": Not found." << std::endl;
-    return -1;
-  }
-  istreambuf_iterator<char> it(ifs);
-  istreambuf_iterator<char> last;
-  string code(it, last);
+  Isolate isolate;
+  Isolate::Scope isolate_scope(&isolate);
 
-  vector<Token *> token_chain;
-  holang::Lexer lexer(code);
-  lexer.lex(token_chain);
-
-  if (show_token) {
-    for (auto *token : token_chain) {
-      cout << token << endl;
+  string src(argv[1]);
+  if (show_token || show_ast) {
+    shared_ptr<const char> code;
+    size_t code_size;
+    if (!load_file(src, code, code_size)) {
+      std::cerr << src << ": Not found." << std::endl;
+      return -1;
+    }
+    vector<Token *> token_chain;
+    holang::Lexer lexer(code.get(), code_size);
+    lexer.lex(token_chain);
+    if (show_token) {
+      for (auto *token : token_chain) {
+        cout << token << endl;
+      }
+      return 0;
+    }
+    holang::Parser parser(token_chain);
+    Node *root = parser.parse();
+    if (root != nullptr) {
+      root->print(0);
     }
     return 0;
   }
 
-  holang::Parser parser(token_chain);
-  Node *root = parser.parse();
-  CodeSequence codes(src);
-  // codes.push_back({.op = Instruction::PUT_ENV});
-  // codes.push_back({.ival = 0});
-  if (root == nullptr) {
-    return 0;
-  }
-  if (show_ast) {
-    root->print(0);
+  if (!snapshot_path.empty()) {
+    // compile only, recording the source as it is now
+    SourceStamp stamp;
+    shared_ptr<const char> code;
+    size_t code_size;
+    if (!SourceStamp::of(src, stamp) || !load_file(src, code, code_size)) {
+      std::cerr << src << ": Not found." << std::endl;
+      return -1;
+    }
+    Module *module = Module::compile(code.get(), code_size, src);
+    ofstream out(snapshot_path, ios::binary | ios::trunc);
+    out << module->snapshot(stamp);
+    if (!out) {
+      std::cerr << snapshot_path << ": can not write." << std::endl;
+      return -1;
+    }
     return 0;
   }
-  root->code_gen(&codes);
-  // codes[1].ival = size_local_idents();
 
-  HolangVM vm(parser.toplevel_val_size());
-  vm.codes = &codes;
+  const Module *module = Module::load(src);
+  HolangVM vm(module->local_size);
+  vm.codes = const_cast<CodeSequence *>(&module->codes);
+  Trace::Scope scope("eval " + src, "run");
   vm.eval();
 }
@@ -0,0 +1,208 @@
+// Pushes values through ChannelQueues from many threads at once, with
+// blocking and non-blocking operations, and sends objects from one isolate
+// to another.
+//
+//   channel_stress [producers] [consumers] [count]
+
+#include "holang/channel.hpp"
+#include "holang/isolate.hpp"
+#include "holang/vm.hpp"
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace holang;
+
+static int failures = 0;
+
+static void check(bool ok, const string &what) {
+  if (!ok) {
+    cerr << "FAIL: " << what << endl;
+    failures++;
+  }
+}
+
+static Message int_message(int64_t i) {
+  Message m;
+  m.kind = Message::Kind::INT;
+  m.ival = i;
+  return m;
+}
+
+// every value pushed is popped exactly once
+static void mpmc(int producers, int consumers, int64_t count, size_t capacity,
+                 bool blocking) {
+  ChannelQueue queue(capacity);
+  atomic<int64_t> popped(0), sum(0);
+  vector<thread> threads;
+  for (int p = 0; p < producers; p++) {
+    threads.emplace_back([&, p] {
+      for (int64_t i = p; i < count; i += producers) {
+        if (blocking) {
+          queue.push(int_message(i));
+        } else {
+          while (queue.try_push(int_message(i)) != ChannelQueue::Status::OK) {
+            this_thread::yield();
+          }
+        }
+      }
+    });
+  }
+  for (int c = 0; c < consumers; c++) {
+    threads.emplace_back([&] {
+      Message m;
+      while (true) {
+        ChannelQueue::Status status =
+            blocking ? queue.pop(m) : queue.try_pop(m);
+        if (status == ChannelQueue::Status::CLOSED) {
+          break;
+        }
+        if (status == ChannelQueue::Status::OK) {
+          popped++;
+          sum += m.ival;
+        } else {
+          this_thread::yield();
+        }
+      }
+    });
+  }
+  for (int p = 0; p < producers; p++) {
+    threads[p].join();
+  }
+  queue.close();
+  for (size_t t = producers; t < threads.size(); t++) {
+    threads[t].join();
+  }
+  string name = string(blocking ? "blocking" : "try") + " capacity " +
+                to_string(capacity);
+  check(popped == count, name + ": popped " + to_string(popped.load()));
+  check(sum == count * (count - 1) / 2, name + ": sum " + to_string(sum));
+}
+
+// a queue takes exactly `capacity` values, whatever its slots round up to
+static void exact_capacity() {
+  for (size_t capacity : {1, 3, 5, 8}) {
+    ChannelQueue queue(capacity);
+    size_t pushed = 0;
+    while (queue.try_push(int_message(pushed)) == ChannelQueue::Status::OK) {
+      pushed++;
+    }
+    check(pushed == capacity, "capacity " + to_string(capacity) + ": took " +
+                                  to_string(pushed));
+    Message m;
+    check(queue.try_pop(m) == ChannelQueue::Status::OK && m.ival == 0,
+          "capacity " + to_string(capacity) + ": first value");
+    check(queue.try_push(int_message(pushed)) == ChannelQueue::Status::OK,
+          "capacity " + to_string(capacity) + ": push after a pop");
+  }
+}
+
+// every push which reports OK while the queue is being closed is popped
+static void close_while_pushing(int producers, int rounds) {
+  for (int round = 0; round < rounds; round++) {
+    ChannelQueue queue(1024);
+    atomic<int64_t> pushed(0), popped(0);
+    atomic<bool> go(false);
+    vector<thread> threads;
+    for (int p = 0; p < producers; p++) {
+      threads.emplace_back([&] {
+        while (!go) {
+          this_thread::yield();
+        }
+        while (true) {
+          ChannelQueue::Status status = queue.try_push(int_message(1));
+          if (status == ChannelQueue::Status::CLOSED) {
+            break;
+          }
+          if (status == ChannelQueue::Status::OK) {
+            pushed++;
+          }
+        }
+      });
+    }
+    threads.emplace_back([&] {
+      Message m;
+      while (queue.pop(m) == ChannelQueue::Status::OK) {
+        popped++;
+      }
+    });
+    go = true;
+    this_thread::yield();
+    queue.close();
+    for (auto &t : threads) {
+      t.join();
+    }
+    if (pushed != popped) {
+      check(false, "close: pushed " + to_string(pushed.load()) +
+                       " but popped " + to_string(popped.load()));
+      return;
+    }
+  }
+}
+
+// objects sent from one isolate arrive as objects of the other
+static void across_isolates() {
+  auto queue = make_shared<ChannelQueue>(4);
+  string long_text(100, 'x');
+
+  thread sender([&] {
+    Isolate isolate;
+    Isolate::Scope scope(&isolate);
+    HolangVM vm(0);
+    std::vector<Value> elements = {Value((int64_t)7),
+                                   Value((Object *)new String(long_text)),
+                                   Value((Object *)new Channel(queue))};
+    Value array((Object *)new Array(std::move(elements)));
+    queue->push(Message::pack(array, "sender"));
+  });
+
+  thread receiver([&] {
+    Isolate isolate;
+    Isolate::Scope scope(&isolate);
+    HolangVM vm(0);
+    Message m;
+    check(queue->pop(m) == ChannelQueue::Status::OK, "cross-isolate pop");
+    Value v = m.unpack();
+    check(Array::is_array(v), "array of the receiving isolate");
+    auto &elements = ((Array *)v.objval)->elements;
+    check(elements.size() == 3, "three elements");
+    check(elements[0].type == Type::INT && elements[0].ival == 7, "int");
+    check(String::is_string(elements[1]) &&
+              ((String *)elements[1].objval)->str() == long_text,
+          "string");
+    check(Channel::is_channel(elements[2]) &&
+              ((Channel *)elements[2].objval)->get_queue() == queue,
+          "channel handle");
+  });
+
+  sender.join();
+  receiver.join();
+}
+
+int main(int argc, char *argv[]) {
+  int producers = 4, consumers = 4;
+  int64_t count = 200000;
+  if (argc > 1) {
+    producers = stoi(argv[1]);
+  }
+  if (argc > 2) {
+    consumers = stoi(argv[2]);
+  }
+  if (argc > 3) {
+    count = stoll(argv[3]);
+  }
+
+  for (size_t capacity : {1, 2, 5, 64}) {
+    mpmc(producers, consumers, count, capacity, true);
+    mpmc(producers, consumers, count, capacity, false);
+  }
+  exact_capacity();
+  close_while_pushing(producers, 200);
+  across_isolates();
+
+  cout << (failures == 0 ? "ok" : "failed") << endl;
+  return failures == 0 ? 0 : 1;
+}
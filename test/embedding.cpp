@@ -0,0 +1,176 @@
+// Loads a script through the embedding API and calls its functions from
+// C++ many times, from one runtime and from several at once.
+//
+//   embedding [calls]
+
+#include "holang/bind.hpp"
+#include "holang/runtime.hpp"
+#include "holang/string.hpp"
+#include <cctype>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace holang;
+
+static int failures = 0;
+
+static void check(bool ok, const string &what) {
+  if (!ok) {
+    cerr << "FAIL: " << what << endl;
+    failures++;
+  }
+}
+
+static const char *RULES = R"(limit = 100
+
+func score(base, weight) {
+  return base * weight + 1
+}
+
+func discount(price, tier) {
+  if tier == "gold" {
+    return price * 0.5
+  }
+  return price
+}
+
+func clamped(x) {
+  return clamp(x, 0.0, 1.0)
+}
+
+func shout(s) {
+  return upcase(s)
+}
+
+func label(n) {
+  return "#{n}:#{n + 1}"
+}
+
+func total(n) {
+  r = 1..n
+  return r.lazy().map() { |x| x * 2 }.to_a().size()
+}
+
+func countdown(n) {
+  while n > 0 {
+    yield n
+    n = n - 1
+  }
+}
+)";
+
+static double clamp(double x, double lo, double hi) {
+  return x < lo ? lo : x > hi ? hi : x;
+}
+
+static string upcase(const string &s) {
+  string out = s;
+  for (char &c : out) {
+    c = toupper(c);
+  }
+  return out;
+}
+
+static bool is_int(const Value &v, int64_t i) {
+  return v.type == Type::INT && v.ival == i;
+}
+
+static void single_runtime(const Module *module, int calls) {
+  Runtime runtime;
+  runtime.define_function("clamp", bind<&clamp>());
+  runtime.define_function("upcase", bind<&upcase>());
+  runtime.run(module);
+  // to inspect the objects returned
+  Isolate::Scope scope(&runtime.get_isolate());
+
+  check(runtime.lookup_function("missing") == nullptr, "missing function");
+  Func *score = runtime.lookup_function("score");
+  Func *discount = runtime.lookup_function("discount");
+  Func *label = runtime.lookup_function("label");
+  Func *total = runtime.lookup_function("total");
+  Func *countdown = runtime.lookup_function("countdown");
+  Func *println = runtime.lookup_function("println");
+  check(score && discount && label && total && countdown && println,
+        "functions defined by the module");
+  if (failures > 0) {
+    return;
+  }
+
+  check(is_int(runtime.call(score, 6, 7), 43), "int arguments");
+  Value half = runtime.call(discount, 10.0, "gold");
+  check(half.type == Type::DOUBLE && half.dval == 5.0, "string argument");
+  Value full = runtime.call(discount, 10.0, string("silver"));
+  check(full.type == Type::DOUBLE && full.dval == 10.0, "std::string");
+  Value text = runtime.call(label, 3);
+  check(String::is_string(text) &&
+            ((String *)text.objval)->str() == "3:4",
+        "string result");
+  check(is_int(runtime.call(total, 5), 5), "block in a called function");
+  Func *clamped = runtime.lookup_function("clamped");
+  Value high = runtime.call(clamped, 3);
+  check(high.type == Type::DOUBLE && high.dval == 1.0, "bound C++ function");
+  Value loud = runtime.call(runtime.lookup_function("shout"), "abc");
+  check(String::is_string(loud) && ((String *)loud.objval)->str() == "ABC",
+        "bound std::string function");
+  Value args[] = {Value((int64_t)2), Value((int64_t)3)};
+  check(is_int(runtime.call(score, args, 2), 7), "Value array");
+  Value generator = runtime.call(countdown, 3);
+  check(generator.type == Type::OBJECT &&
+            generator.objval->klass == Klass::Coroutine,
+        "generator call returns a coroutine");
+  runtime.call(println, "builtin function");
+
+  // repeated calls reuse the stack: no growth, and microseconds each
+  auto start = chrono::steady_clock::now();
+  int64_t sum = 0;
+  for (int i = 0; i < calls; i++) {
+    sum += runtime.call(score, i, 2).ival;
+  }
+  auto elapsed = chrono::steady_clock::now() - start;
+  check(sum == (int64_t)calls * (calls - 1) + calls, "sum of calls");
+  double ns = chrono::duration<double, nano>(elapsed).count() / calls;
+  cout << calls << " calls, " << ns << " ns/call" << endl;
+}
+
+// runtimes on several threads run one compiled module independently
+static void many_runtimes(const Module *module) {
+  vector<thread> threads;
+  vector<int64_t> results(4);
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&, t] {
+      Runtime runtime;
+      runtime.run(module);
+      Func *score = runtime.lookup_function("score");
+      int64_t sum = 0;
+      for (int i = 0; i < 10000; i++) {
+        sum += runtime.call(score, t, i).ival;
+      }
+      results[t] = sum;
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (int t = 0; t < 4; t++) {
+    check(results[t] == (int64_t)t * 10000 * 9999 / 2 + 10000,
+          "runtime on thread " + to_string(t));
+  }
+}
+
+int main(int argc, char *argv[]) {
+  int calls = 1000000;
+  if (argc > 1) {
+    calls = stoi(argv[1]);
+  }
+
+  const Module *module = Module::compile(RULES, "rules.ho");
+  single_runtime(module, calls);
+  many_runtimes(module);
+
+  cout << (failures == 0 ? "ok" : "failed") << endl;
+  return failures == 0 ? 0 : 1;
+}
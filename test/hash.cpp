@@ -0,0 +1,74 @@
+// Checks that erased entries of a Hash are compacted away under churn, and
+// that a pinned Hash keeps the positions of its entries while it changes.
+
+#include "holang/hash.hpp"
+#include "holang/isolate.hpp"
+#include <iostream>
+#include <string>
+
+using namespace std;
+using namespace holang;
+
+static int failures = 0;
+
+static void check(bool ok, const string &what) {
+  if (!ok) {
+    cerr << "FAIL: " << what << endl;
+    failures++;
+  }
+}
+
+int main() {
+  Isolate isolate;
+  Isolate::Scope scope(&isolate);
+
+  // at most 4 live keys at a time, 3 after each erase
+  Hash churn;
+  size_t largest = 0;
+  for (int64_t i = 0; i < 100000; i++) {
+    churn.insert(Value(i), Value(i * 2));
+    churn.erase(Value(i - 3));
+    largest = max(largest, churn.get_entries().size());
+  }
+  check(churn.size() == 3, "size after churn");
+  check(largest <= 2 * 4 + 16 + 1,
+        "entries grew to " + to_string(largest) + " with 4 live keys");
+  for (int64_t i = 99997; i < 100000; i++) {
+    Value *v = churn.find(Value(i));
+    check(v != nullptr && v->ival == i * 2, "find " + to_string(i));
+  }
+  check(churn.find(Value((int64_t)99996)) == nullptr, "erased key found");
+
+  // what Hash#each does while its block inserts and deletes
+  Hash pinned;
+  for (int64_t i = 0; i < 8; i++) {
+    pinned.insert(Value(i), Value(i));
+  }
+  int64_t visited = 0;
+  {
+    Hash::Pin pin(&pinned);
+    const auto &entries = pinned.get_entries();
+    size_t end = entries.size();
+    for (size_t i = 0; i < end; i++) {
+      if (!entries[i].live) {
+        continue;
+      }
+      int64_t key = entries[i].key.ival;
+      check(key == static_cast<int64_t>(i), "entry moved to " + to_string(i));
+      visited++;
+      pinned.erase(Value(key + 1));
+      for (int64_t j = 0; j < 100; j++) {
+        pinned.insert(Value(1000 + key * 100 + j), Value(j));
+      }
+    }
+  }
+  check(visited == 4, "visited " + to_string(visited) + " of 0, 2, 4, 6");
+  check(pinned.size() == 4 + 400, "size after pinned changes");
+  pinned.insert(Value((int64_t)-1), Value((int64_t)-1));
+  check(pinned.find(Value((int64_t)6)) != nullptr &&
+            pinned.find(Value((int64_t)7)) == nullptr,
+        "lookups after unpinning");
+
+  cout << (failures == 0 ? "ok" : "failed") << endl;
+  return failures == 0 ? 0 : 1;
+}
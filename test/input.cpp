@@ -0,0 +1,109 @@
+// Runs scripts which read their standard input through read_int and the
+// other input builtins, and compares what they print.
+
+#include "holang/isolate.hpp"
+#include "holang/module.hpp"
+#include "holang/vm.hpp"
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+using namespace std;
+using namespace holang;
+
+static int failures = 0;
+
+static void check(bool ok, const string &what) {
+  if (!ok) {
+    cerr << "FAIL: " << what << endl;
+    failures++;
+  }
+}
+
+static string read_all(FILE *file) {
+  string content;
+  char buf[4096];
+  rewind(file);
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), file)) != 0) {
+    content.append(buf, n);
+  }
+  return content;
+}
+
+// the output of `script` run in a fresh isolate reading `input`
+static string run(const string &script, const string &input) {
+  FILE *in = tmpfile();
+  FILE *out = tmpfile();
+  fwrite(input.data(), 1, input.size(), in);
+  rewind(in);
+  {
+    Isolate isolate(fileno(in), fileno(out));
+    Isolate::Scope scope(&isolate);
+    const Module *module =
+        Module::compile(script.data(), script.size(), "input.ho");
+    HolangVM vm(module->local_size);
+    vm.codes = const_cast<CodeSequence *>(&module->codes);
+    vm.eval();
+  }
+  fclose(in);
+  string output = read_all(out);
+  fclose(out);
+  return output;
+}
+
+// tasks on worker threads share the input of the isolate
+static void concurrent_reads() {
+  string input;
+  int64_t sum = 0;
+  for (int i = 0; i < 8000; i++) {
+    input += to_string(i) + " ";
+    sum += i;
+  }
+  string script = "futures = []\n"
+                  "for k in 0..7 {\n"
+                  "  futures.push(spawn {\n"
+                  "    s = 0\n"
+                  "    i = 0\n"
+                  "    while i < 1000 {\n"
+                  "      s = s + read_int()\n"
+                  "      i = i + 1\n"
+                  "    }\n"
+                  "    s\n"
+                  "  })\n"
+                  "}\n"
+                  "println(futures.map() { |f| await(f) }.sum())\n";
+  for (int round = 0; round < 20; round++) {
+    string output = run(script, input);
+    if (output != to_string(sum) + "\n") {
+      check(false, "concurrent reads: " + output);
+      return;
+    }
+  }
+}
+
+// read_int returns false at the end of the input, unlike a 0 in it
+static void end_of_input() {
+  string script = "more = 1\n"
+                  "while more > 0 {\n"
+                  "  done = eof()\n"
+                  "  if done {\n"
+                  "    more = 0\n"
+                  "  } else {\n"
+                  "    print(read_int(), \" \")\n"
+                  "  }\n"
+                  "}\n"
+                  "println(read_int(), eof())\n";
+  string output = run(script, "0 5\n-3 0\n");
+  check(output == "0 5 -3 0 false true\n", "end of input: " + output);
+  output = run(script, "");
+  check(output == "false true\n", "empty input: " + output);
+}
+
+int main() {
+  concurrent_reads();
+  end_of_input();
+
+  cout << (failures == 0 ? "ok" : "failed") << endl;
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,147 @@
+// Runs the examples/ corpus on many threads at once, each script in its own
+// Isolate, and compares every output with test/<name>.out.
+//
+//   isolate_stress [threads] [rounds]
+//
+// Run from the repository root.
+
+#include "holang/file.hpp"
+#include "holang/isolate.hpp"
+#include "holang/lexer.hpp"
+#include "holang/parser.hpp"
+#include "holang/vm.hpp"
+#include <atomic>
+#include <cstdio>
+#include <dirent.h>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace holang;
+
+// examples which can not run concurrently with themselves
+static const vector<string> skipped = {
+    "file", // writes a fixed path under /tmp
+};
+
+static vector<string> example_names() {
+  vector<string> names;
+  DIR *dir = opendir("examples");
+  if (dir == nullptr) {
+    cerr << "examples/: not found; run from the repository root" << endl;
+    exit(1);
+  }
+  while (dirent *entry = readdir(dir)) {
+    string file = entry->d_name;
+    if (file.size() <= 3 || file.compare(file.size() - 3, 3, ".ho") != 0) {
+      continue;
+    }
+    string name = file.substr(0, file.size() - 3);
+    bool skip = false;
+    for (const auto &s : skipped) {
+      skip = skip || s == name;
+    }
+    if (!skip) {
+      names.push_back(name);
+    }
+  }
+  closedir(dir);
+  return names;
+}
+
+static string read_all(FILE *file) {
+  string content;
+  char buf[4096];
+  rewind(file);
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), file)) != 0) {
+    content.append(buf, n);
+  }
+  return content;
+}
+
+// the output of examples/<name>.ho run in a fresh isolate
+static string run_example(const string &name) {
+  string path = "examples/" + name + ".ho";
+  FILE *out = tmpfile();
+  int in = open("/dev/null", O_RDONLY);
+  {
+    Isolate isolate(in, fileno(out));
+    Isolate::Scope scope(&isolate);
+
+    shared_ptr<const char> code;
+    size_t code_size;
+    if (!load_file(path, code, code_size)) {
+      cerr << path << ": Not found." << endl;
+      exit(1);
+    }
+    vector<Token *> token_chain;
+    Lexer lexer(code.get(), code_size);
+    lexer.lex(token_chain);
+    Parser parser(token_chain);
+    Node *root = parser.parse();
+    CodeSequence codes(path);
+    if (root != nullptr) {
+      root->code_gen(&codes);
+    }
+    HolangVM vm(parser.toplevel_val_size());
+    vm.codes = &codes;
+    vm.eval();
+  }
+  close(in);
+  string output = read_all(out);
+  fclose(out);
+  return output;
+}
+
+int main(int argc, char *argv[]) {
+  unsigned threads = max(4u, thread::hardware_concurrency());
+  int rounds = 3;
+  if (argc > 1) {
+    threads = stoi(argv[1]);
+  }
+  if (argc > 2) {
+    rounds = stoi(argv[2]);
+  }
+
+  vector<string> names = example_names();
+  vector<string> expected;
+  for (const auto &name : names) {
+    ifstream ifs("test/" + name + ".out");
+    stringstream ss;
+    ss << ifs.rdbuf();
+    expected.push_back(ss.str());
+  }
+
+  atomic<int> runs(0);
+  atomic<int> failures(0);
+  vector<thread> workers;
+  for (unsigned t = 0; t < threads; t++) {
+    workers.emplace_back([&, t] {
+      // every thread walks the corpus from a different example
+      for (int r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < names.size(); i++) {
+          size_t k = (i + t) % names.size();
+          if (run_example(names[k]) != expected[k]) {
+            cerr << "thread " << t << ": " << names[k] << ": output differs"
+                 << endl;
+            failures++;
+          }
+          runs++;
+        }
+      }
+    });
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+
+  cout << runs << " runs on " << threads << " threads, " << failures
+       << " failures" << endl;
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,43 @@
+// Checks the counters of `ho --stats` for a program of one instruction,
+// whose only pair is the one from the start of the program.
+
+#include "holang/isolate.hpp"
+#include "holang/stats.hpp"
+#include "holang/vm.hpp"
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using namespace std;
+using namespace holang;
+
+int main() {
+#ifdef HOLANG_ENABLE_STATS
+  Isolate isolate;
+  Isolate::Scope scope(&isolate);
+
+  CodeSequence codes;
+  codes.append(Instruction::PUT_INT);
+  codes.append((int64_t)1);
+
+  Stats::enabled = true;
+  HolangVM vm(0);
+  vm.codes = &codes;
+  vm.eval();
+  Stats::enabled = false;
+
+  ostringstream out;
+  Stats::report(out);
+  string report = out.str();
+  bool ok = report.find("(1 executed)") != string::npos &&
+            report.find("(start) -> PUT_INT") != string::npos;
+  if (!ok) {
+    cerr << "FAIL:\n" << report;
+  }
+  cout << (ok ? "ok" : "failed") << endl;
+  return ok ? 0 : 1;
+#else
+  cout << "skipped: built without HOLANG_ENABLE_STATS" << endl;
+  return 0;
+#endif
+}
@@ -0,0 +1,54 @@
+// Bounds the bytes allocated by `s = s + piece` in a loop, which copied the
+// whole of s on every "+" before concat() appended in place.
+
+#include "holang/isolate.hpp"
+#include "holang/module.hpp"
+#include "holang/vm.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+
+using namespace std;
+using namespace holang;
+
+static atomic<size_t> allocated(0);
+
+void *operator new(size_t size) {
+  allocated += size;
+  void *p = malloc(size == 0 ? 1 : size);
+  if (p == nullptr) {
+    throw bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+int main() {
+  Isolate isolate;
+  Isolate::Scope scope(&isolate);
+
+  // 20000 pieces of 10 bytes: copying s every time would allocate 2 GB
+  const int pieces = 20000;
+  const Module *module = Module::compile(
+      "s = \"\"\ni = 0\nwhile i < " + to_string(pieces) +
+          " {\n  s = s + \"0123456789\"\n  i = i + 1\n}\n",
+      "concat.ho");
+  HolangVM vm(module->local_size);
+  vm.codes = const_cast<CodeSequence *>(&module->codes);
+  size_t before = allocated;
+  vm.eval();
+  size_t bytes = allocated - before;
+
+  // the final buffer and its doublings, plus one String object per "+"
+  size_t bound = 4 * pieces * 10 + pieces * 2 * sizeof(String);
+  bool ok = bytes <= bound;
+  if (!ok) {
+    cerr << "FAIL: " << bytes << " bytes allocated, bound " << bound << endl;
+  }
+  cout << (ok ? "ok" : "failed") << endl;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,225 @@
+// Checks the stack depths the Verifier computes for hand-written code and
+// that it rejects code whose stack effects do not balance or which uses
+// slots outside its frame.
+
+#include "holang/isolate.hpp"
+#include "holang/module.hpp"
+#include "holang/verifier.hpp"
+#include <iostream>
+#include <string>
+
+using namespace std;
+using namespace holang;
+
+static int failures = 0;
+
+static void check(bool ok, const string &what) {
+  if (!ok) {
+    cerr << "FAIL: " << what << endl;
+    failures++;
+  }
+}
+
+static void accepts(CodeSequence codes, int max_stack, const string &what,
+                    int local_size = 1) {
+  string error;
+  check(Verifier::verify(codes, local_size, error), what + ": " + error);
+  check(codes.max_stack == max_stack,
+        what + ": max_stack " + to_string(codes.max_stack));
+}
+
+static void rejects(CodeSequence codes, const string &what,
+                    int local_size = 1) {
+  string error;
+  check(!Verifier::verify(codes, local_size, error), what + " accepted");
+}
+
+// 3.times() { |i| } with the loop variable `var` and the counter at `slot`
+static CodeSequence times_loop(int kind, int var, int slot) {
+  CodeSequence codes;
+  codes.append(Instruction::PUT_INT);
+  codes.append((int64_t)3);
+  codes.append(Instruction::LOOP_PREP);
+  codes.append(kind);
+  codes.append(var);
+  codes.append(slot);
+  size_t to_exit = codes.size();
+  codes.append(0);
+  codes.append(-1);
+  size_t body = codes.size();
+  codes.append(Instruction::LOOP_STEP);
+  codes.append(var);
+  codes.append(slot);
+  codes.append((int)body);
+  codes.patch(to_exit, codes.size());
+  codes.append(Instruction::PUT_BOOL);
+  codes.append(true);
+  codes.append(Instruction::RET);
+  return codes;
+}
+
+int main() {
+  CodeSequence add;
+  add.append(Instruction::PUT_INT);
+  add.append((int64_t)1);
+  add.append(Instruction::PUT_INT);
+  add.append((int64_t)2);
+  add.append(Instruction::ADD);
+  add.append(Instruction::RET);
+  accepts(add, 2, "1 + 2");
+
+  // if true { 1 } else { self.f(2, 3) }
+  CodeSequence branches;
+  branches.append(Instruction::PUT_BOOL);
+  branches.append(true);
+  branches.append(Instruction::JUMP_IFNOT);
+  size_t to_else = branches.size();
+  branches.append(0);
+  branches.append(Instruction::PUT_INT);
+  branches.append((int64_t)1);
+  branches.append(Instruction::JUMP);
+  size_t to_end = branches.size();
+  branches.append(0);
+  branches.patch(to_else, branches.size());
+  branches.append(Instruction::PUT_SELF);
+  branches.append(Instruction::PUT_INT);
+  branches.append((int64_t)2);
+  branches.append(Instruction::PUT_INT);
+  branches.append((int64_t)3);
+  branches.append(Instruction::CALL_FUNC);
+  branches.append(new string("f"));
+  branches.append(2);
+  branches.patch(to_end, branches.size());
+  branches.append(Instruction::RET);
+  branches.append(Instruction::RET);
+  accepts(branches, 3, "branches");
+
+  CodeSequence underflow;
+  underflow.append(Instruction::PUT_INT);
+  underflow.append((int64_t)1);
+  underflow.append(Instruction::ADD);
+  rejects(underflow, "ADD of one value");
+
+  // a loop whose body leaves a value behind on every iteration
+  CodeSequence leak;
+  leak.append(Instruction::PUT_BOOL);
+  leak.append(true);
+  leak.append(Instruction::JUMP_IFNOT);
+  size_t to_exit = leak.size();
+  leak.append(0);
+  leak.append(Instruction::PUT_INT);
+  leak.append((int64_t)1);
+  leak.append(Instruction::JUMP);
+  leak.append(0);
+  leak.patch(to_exit, leak.size());
+  rejects(leak, "leaking loop");
+
+  // the operand of PUT_INT is at byte 6
+  CodeSequence into_operand;
+  into_operand.append(Instruction::JUMP);
+  into_operand.append(6);
+  into_operand.append(Instruction::PUT_INT);
+  into_operand.append((int64_t)1);
+  rejects(into_operand, "jump into an operand");
+
+  // PUT_STRING of the second constant of a table with one
+  CodeSequence no_constant;
+  no_constant.append(Instruction::PUT_STRING);
+  no_constant.append(new string("a"));
+  no_constant.append(Instruction::PUT_STRING);
+  no_constant.append(1);
+  no_constant.append(Instruction::RET);
+  rejects(no_constant, "constant out of the table");
+
+  CodeSequence prev_env;
+  prev_env.append(Instruction::PREV_ENV);
+  rejects(prev_env, "PREV_ENV outside a class body");
+
+  // slots of a frame of self and one local
+  CodeSequence load_local;
+  load_local.append(Instruction::LOAD_LOCAL);
+  load_local.append(1);
+  load_local.append(Instruction::RET);
+  accepts(load_local, 1, "LOAD_LOCAL 1 of 2", 2);
+  rejects(load_local, "LOAD_LOCAL 1 of 1");
+
+  CodeSequence store_local;
+  store_local.append(Instruction::PUT_INT);
+  store_local.append((int64_t)1);
+  store_local.append(Instruction::STORE_LOCAL);
+  store_local.append(-1);
+  store_local.append(Instruction::RET);
+  rejects(store_local, "STORE_LOCAL -1", 2);
+
+  // a class body runs in the class, which has no slots but self
+  CodeSequence class_local;
+  class_local.append(Instruction::LOAD_CLASS);
+  class_local.append(new string("A"));
+  class_local.append(Instruction::LOAD_LOCAL);
+  class_local.append(1);
+  class_local.append(Instruction::POP);
+  class_local.append(Instruction::PREV_ENV);
+  class_local.append(Instruction::RET);
+  rejects(class_local, "LOAD_LOCAL 1 in a class body", 2);
+
+  // the loop variable and two hidden slots: 1, 2 and 3 of 4
+  int times = static_cast<int>(LoopKind::TIMES);
+  accepts(times_loop(times, 1, 2), 1, "times loop", 4);
+  accepts(times_loop(times, -1, 2), 1, "times loop without a variable", 4);
+  rejects(times_loop(times, 1, 3), "loop slots past the frame", 4);
+  rejects(times_loop(times, 4, 2), "loop variable past the frame", 4);
+  rejects(times_loop(times, -2, 2), "loop variable -2", 4);
+  rejects(times_loop(times, 1, -1), "loop slot -1", 4);
+  rejects(times_loop(3, 1, 2), "loop kind 3", 4);
+  rejects(times_loop(-1, 1, 2), "loop kind -1", 4);
+
+  // s = 0, captured by a block which adds 1 to it
+  CodeSequence block;
+  block.append(Instruction::LOAD_CELL);
+  block.append(1);
+  block.append(Instruction::PUT_INT);
+  block.append((int64_t)1);
+  block.append(Instruction::ADD);
+  block.append(Instruction::STORE_CELL);
+  block.append(1);
+  block.append(Instruction::RET);
+  accepts(block, 2, "block adding to a cell", 2);
+  rejects(block, "LOAD_CELL 1 of 1");
+  auto closure = [&block](int from, int to) {
+    auto *func = new Func(block, 2);
+    func->captures.emplace_back(from, to);
+    CodeSequence codes;
+    codes.append(Instruction::PUT_INT);
+    codes.append((int64_t)0);
+    codes.append(Instruction::STORE_LOCAL);
+    codes.append(1);
+    codes.append(Instruction::POP);
+    codes.append(Instruction::MAKE_CELL);
+    codes.append(1);
+    codes.append(Instruction::MAKE_CLOSURE);
+    codes.append(func);
+    codes.append(Instruction::RET);
+    return codes;
+  };
+  accepts(closure(1, 1), 1, "closure", 2);
+  rejects(closure(2, 1), "closure of a cell past the frame", 2);
+  auto verify_all = [](CodeSequence codes) {
+    string error;
+    return Verifier::verify_all(codes, 2, error);
+  };
+  check(verify_all(closure(1, 1)), "closure rejected");
+  check(!verify_all(closure(1, 2)), "cell put past the block's frame accepted");
+  check(!verify_all(closure(1, 0)), "cell put to self accepted");
+
+  // compiled code, which Module::compile verifies
+  Isolate isolate;
+  Isolate::Scope scope(&isolate);
+  const Module *module = Module::compile(
+      "i = 0\nwhile i < 3 {\n  i = i + 1\n}\nclass A {\n  func f(x) {\n"
+      "    return [x, x * 2]\n  }\n}\ns = 0\n3.times() { |k| s = s + k }\n",
+      "loops.ho");
+  check(module->codes.max_stack >= 1, "compiled module");
+
+  cout << (failures == 0 ? "ok" : "failed") << endl;
+  return failures == 0 ? 0 : 1;
+}